@@ -0,0 +1,137 @@
+/**
+ * Scaling benchmark of the TileRenderer on the host
+ * 
+ * Renders a 240 x 320 Mandelbrot set with 1, 2, 4 and 8 threads 
+ * and prints the time and the speedup against 1 thread. The same is
+ * done for the Sierpinski chaos game plotted into a PointMap, like
+ * the IFS activities: the points are shared among the threads, each
+ * with its own random sequence, so its checksums differ a little.
+ * 
+ * Build and run   pio run -e native -t exec
+ *   or            g++ -std=gnu++11 -O2 -pthread -Ilib/TileRenderer -Ilib/DrawTrace
+ *                     bench/tileBench.cpp lib/TileRenderer/TileRenderer.cpp
+ *                     lib/TileRenderer/TileRendererHost.cpp -o tileBench
+*/
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "TileRenderer.h"
+
+constexpr int WIDTH = 240;
+constexpr int HEIGHT = 320;
+constexpr int MAX_ITERATION = 1000;
+constexpr int CHAOS_POINTS = 4000000;
+
+static void mandelbrotTile(Tile &t, void *)
+{
+    uint16_t *p = t.pixels;
+    for (int zeile = t.y; zeile < t.y + t.h; zeile++)
+    {
+        float c_im = (zeile - HEIGHT/2.0) * 4.0 / HEIGHT;
+        for (int spalte = t.x; spalte < t.x + t.w; spalte++)
+        {
+            float c_re = (spalte - WIDTH/2.0) * 4.0 / WIDTH;
+            float x = 0, y = 0, xx = 0, yy = 0;
+            int iteration = 0;
+            while (xx + yy <= 4 && iteration < MAX_ITERATION)
+            {
+                y = 2*x*y + c_im;
+                x = xx - yy + c_re;
+                xx = x*x;
+                yy = y*y;
+                iteration++;
+            }
+            *p++ = iteration == MAX_ITERATION ? 0 : iteration * 0x0821;
+        }
+    }
+}
+
+struct Chaos
+{
+    PointMap *map;
+    int points;                 // per thread
+};
+
+/**
+ * The chaos game of the Sierpinski activity: jump half way towards
+ * a random corner and plot the point in the color of that corner
+*/
+static void chaosJob(int worker, void *ctx)
+{
+    Chaos &c = *(Chaos*)ctx;
+    const int ecke[3][2] = {{0,0}, {WIDTH,0}, {WIDTH/2,HEIGHT}};
+    uint32_t rng = 2463534242u + worker;
+    int px = 20, py = 20;
+    for (int i = 0; i < c.points; i++)
+    {
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+        int k = (uint64_t)rng * 3 >> 32;
+        px = (ecke[k][0] - px) / 2 + px;
+        py = (ecke[k][1] - py) / 2 + py;
+        c.map->plot(px, py, k + 1);
+    }
+}
+
+/**
+ * Copies the tiles into a frame buffer, like the DMA flush on the ESP32
+*/
+class FrameSink : public TileSink
+{
+    public:
+        FrameSink() : frame(WIDTH * HEIGHT) {}
+        void flush(const Tile &t) override
+        {
+            for (int y = 0; y < t.h; y++)
+                for (int x = 0; x < t.w; x++)
+                    frame[(t.y + y) * WIDTH + t.x + x] = t.pixels[y * t.w + x];
+        }
+        uint32_t checksum() const
+        {
+            uint32_t sum = 0;
+            for (uint16_t c : frame) sum = sum * 31 + c;
+            return sum;
+        }
+        std::vector<uint16_t> frame;
+};
+
+int main()
+{
+    TileRenderer renderer(WIDTH, HEIGHT);
+    ShaderSource shader(mandelbrotTile);
+    double single = 0;
+
+    printf("Mandelbrot\nthreads      ms  speedup  checksum\n");
+    for (int threads : {1, 2, 4, 8})
+    {
+        FrameSink sink;
+        auto start = std::chrono::steady_clock::now();
+        renderTiles(threads, renderer, shader, sink);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) single = ms;
+        printf("%7d %7.1f %8.2f  %08x\n", threads, ms, single / ms, sink.checksum());
+        renderer.printStats();
+    }
+
+    const uint16_t palette[4] = { 0x0000, 0xF800, 0x001F, 0x07E0 };    // black, red, blue, green
+    std::vector<uint32_t> buf(PointMap::words(WIDTH, HEIGHT));
+    PointMap map(buf.data(), WIDTH, HEIGHT, palette);
+
+    printf("\nSierpinski chaos game, %d points\nthreads      ms  speedup  checksum\n", CHAOS_POINTS);
+    for (int threads : {1, 2, 4, 8})
+    {
+        FrameSink sink;
+        Chaos chaos = { &map, CHAOS_POINTS / threads };
+        auto start = std::chrono::steady_clock::now();
+        map.clear();
+        runOnWorkers(threads, chaosJob, &chaos);
+        renderTiles(threads, renderer, map, sink);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (threads == 1) single = ms;
+        printf("%7d %7.1f %8.2f  %08x\n", threads, ms, single / ms, sink.checksum());
+        renderer.printStats();
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+/**
+ * Registry of the graphical activities
+ * 
+ * Each activity is a function drawing one screen. Besides its name 
+ * it declares how expensive it is, which render path it needs, the 
+ * orientation it is designed for and whether it draws the same 
+ * image on every run. The table itself is a constant defined in 
+ * activities.cpp, the run statistics are kept beside it.
+*/
+
+#pragma once
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+
+using Action = void(&)(LGFX &lcd);
+
+// Portrait = 0, Landscape = 1, Portrait reversed = 2, Landscape reversed = 3
+// and the corresponding mirrored orientations 4..7
+// The width of the display must be the larger dimension of the display 
+// and the rotation offset must be 5 for lcd and 0 for touch pad
+enum class ROT : uint8_t { PORTRAIT,    LANDSCAPE,   R_PORTRAIT,  R_LANDSCAPE, 
+                           M_PORTRAIT,  M_LANDSCAPE, RM_PORTRAIT, RM_LANDSCAPE 
+                         };
+
+enum class COST : uint8_t { LIGHT,    // a few large primitives
+                            MEDIUM,   // hundreds of primitives or animated with delays
+                            HEAVY     // per pixel computation or ten thousands of primitives
+                          };
+
+enum class BUF : uint8_t { DIRECT,    // draws with LGFX primitives directly to the panel
+                           LINE,      // computes rows into the Scanline or VScroll buffers
+                           TILE,      // rendered in parallel into the TileRenderer tiles
+                           FRAME      // animation, frames rendered in bands by the FramePipeline
+                         };
+
+using Activity = struct act
+{
+  const char *name; 
+  Action f;
+  COST cost;
+  BUF  buffer;
+  ROT  rotation;
+  bool seeded;            // draws from the activity seed, the same seed gives the same image
+};
+
+using ActivityStats = struct actStats
+{
+  uint32_t runs;
+  uint32_t minUs;
+  uint32_t maxUs;
+  uint64_t totalUs;
+  uint32_t primitives;    // of the last run
+  uint32_t bytesFlushed;  // of the last run
+  uint32_t listIn;        // primitives added to display lists in the last run
+  uint32_t listOut;       // primitives sent from display lists in the last run
+  uint32_t seed;          // activity seed of the last run
+};
+
+extern const Activity activity[];
+extern const int nbrActivities;
+extern ActivityStats activityStats[];
+
+void runActivity(LGFX &lcd, int i);
+void printActivityTable();
+void requestTrace(int i);
+void fixSeed(uint32_t seed);
+void traceFilename(char *buf, size_t len, int i);
+uint32_t activityTableHash();
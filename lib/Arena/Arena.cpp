@@ -0,0 +1,90 @@
+#include "Arena.h"
+
+Arena frameArena("frame");
+Arena persistentArena("persistent");
+
+
+/**
+ * Reserve the block of the arena, called once at boot
+*/
+bool Arena::begin(size_t size, uint32_t caps)
+{
+    if (_base != nullptr) return true;
+    _base = (uint8_t*)heap_caps_malloc(size, caps);
+    if (_base == nullptr)
+    {
+        log_e("No memory for the %s arena of %u bytes", _name, size);
+        return false;
+    }
+    _size = size;
+    _used = 0;
+    return true;
+}
+
+
+void *Arena::allocate(size_t bytes, size_t align)
+{
+    size_t start = (_used + align - 1) & ~(align - 1);
+    if (_base == nullptr || start + bytes > _size)
+    {
+        _failures++;
+        return nullptr;
+    }
+    _used = start + bytes;
+    if (_used > _peak) _peak = _used;
+    _allocs++;
+    return _base + start;
+}
+
+
+Arena::Mark Arena::mark()
+{
+    if (_marks < MAX_MARKS) _mark[_marks] = _used;
+    _marks++;
+    return _used;
+}
+
+
+/**
+ * Return everything allocated after mark m. m must be the newest mark
+ * still held and not above the top of the arena.
+*/
+void Arena::release(Mark m)
+{
+    bool newest = _marks > 0 && (_marks > MAX_MARKS || _mark[_marks - 1] == m);
+    if (! newest || m > _used)
+    {
+        log_e("%s arena: release to %u out of order, %u used, %d marks held", _name, m, _used, _marks);
+        return;
+    }
+    _marks--;
+    _used = m;
+}
+
+
+void Arena::print() const
+{
+    Serial.printf("%-10s  %7u  %7u  %7u  %8u  %8u\n", _name, _size, _used, _peak, _allocs, _failures);
+}
+
+
+/**
+ * Reserve the arenas before the heap gets fragmented
+*/
+void beginArenas()
+{
+    frameArena.begin(FRAME_ARENA_SIZE, MALLOC_CAP_DMA | MALLOC_CAP_INTERNAL);
+    if (heap_caps_get_total_size(MALLOC_CAP_SPIRAM) >= PERSISTENT_ARENA_PSRAM)
+        persistentArena.begin(PERSISTENT_ARENA_PSRAM, MALLOC_CAP_SPIRAM);
+    else
+        persistentArena.begin(PERSISTENT_ARENA_INTERNAL, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+}
+
+
+void printArenas()
+{
+    Serial.printf("\narena          size     used     peak    allocs  failures\n");
+    frameArena.print();
+    persistentArena.print();
+    Serial.printf("\n");
+}
@@ -0,0 +1,124 @@
+/**
+ * Arena allocator
+ * 
+ * An arena reserves one block of memory at boot and hands out aligned 
+ * pieces of it by moving a pointer forward. Nothing is freed singly: 
+ * an ArenaScope returns everything allocated after its creation when 
+ * it ends, reset() empties the whole arena. Both are O(1), and since 
+ * the block is never given back to the heap, the buffers allocated 
+ * again and again for every activity can't fragment it.
+ * 
+ * frameArena       DMA capable internal RAM, emptied before every 
+ *                  activity. For line, strip, band and point buffers.
+ * persistentArena  PSRAM when the board has it, else internal RAM. 
+ *                  Never emptied, holds data kept for the whole run 
+ *                  like the geometry cache.
+ * 
+ * When an arena is full alloc() returns nullptr and the caller falls 
+ * back to the heap. The failures are counted in the statistics.
+ * 
+ * Marks are released in the reverse order they were taken, a release
+ * below a mark that is still held would hand its memory out twice.
+ * release() logs such an error. An object keeping buffers from one 
+ * call to another holds its mark in an ArenaHold.
+ * 
+ * Usage    beginArenas();
+ *          ...
+ *          ArenaScope scope(frameArena);
+ *          uint16_t *line = frameArena.alloc<uint16_t>(lcd.width());
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+
+class Arena
+{
+    public:
+        using Mark = size_t;
+
+        Arena(const char *name) : _name(name) {}
+        Arena(const Arena&) = delete;
+        Arena &operator=(const Arena&) = delete;
+
+        bool  begin(size_t size, uint32_t caps);
+        void *allocate(size_t bytes, size_t align = 4);
+        template<typename T> T *alloc(size_t n) 
+        { 
+            return static_cast<T*>(allocate(n * sizeof(T), alignof(T) < 4 ? 4 : alignof(T))); 
+        }
+
+        static constexpr int MAX_MARKS = 8;     // checked for the release order
+
+        Mark mark();
+        void release(Mark m);
+        void reset() { _used = 0; _marks = 0; }
+        bool contains(const void *p) const { return p >= _base && p < _base + _size; }
+
+        const char *name() const { return _name; }
+        size_t size() const { return _size; }
+        size_t used() const { return _used; }
+        size_t peak() const { return _peak; }
+        void   print() const;
+
+    private:
+        const char *_name;
+        uint8_t *_base = nullptr;
+        size_t   _size = 0;
+        size_t   _used = 0;
+        size_t   _peak = 0;
+        uint32_t _allocs = 0;
+        uint32_t _failures = 0;
+        Mark     _mark[MAX_MARKS];          // held marks, the newest last
+        int      _marks = 0;
+};
+
+
+/**
+ * Returns the memory allocated during its lifetime to the arena
+*/
+class ArenaScope
+{
+    public:
+        ArenaScope(Arena &arena) : _arena(arena), _mark(arena.mark()) {}
+        ~ArenaScope() { _arena.release(_mark); }
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope &operator=(const ArenaScope&) = delete;
+
+    private:
+        Arena &_arena;
+        Arena::Mark _mark;
+};
+
+
+/**
+ * A mark held by an object from take() to release() across calls, 
+ * e.g. for buffers allocated in begin() and returned in end()
+*/
+class ArenaHold
+{
+    public:
+        ArenaHold(Arena &arena) : _arena(arena) {}
+        ~ArenaHold() { release(); }
+        ArenaHold(const ArenaHold&) = delete;
+        ArenaHold &operator=(const ArenaHold&) = delete;
+
+        void take() { release(); _mark = _arena.mark(); _held = true; }
+        void release() { if (_held) _arena.release(_mark); _held = false; }
+
+    private:
+        Arena &_arena;
+        Arena::Mark _mark = 0;
+        bool _held = false;
+};
+
+
+constexpr size_t FRAME_ARENA_SIZE = 48 * 1024;          // two band sprites of 240 x 40 pixels
+constexpr size_t PERSISTENT_ARENA_PSRAM = 256 * 1024;
+constexpr size_t PERSISTENT_ARENA_INTERNAL = 16 * 1024;
+
+extern Arena frameArena;
+extern Arena persistentArena;
+
+void beginArenas();
+void printArenas();
@@ -0,0 +1,85 @@
+#include "BootStages.h"
+#include <esp_timer.h>
+
+BootStages bootStages;
+
+
+/**
+ * Record the end of the stage name, may be called from any task
+*/
+void BootStages::mark(const char *name)
+{
+    uint32_t us = esp_timer_get_time();
+    int i = _count.fetch_add(1);
+    if (i >= MAX_STAGES)
+    {
+        _count = MAX_STAGES;
+        return;
+    }
+    _stage[i] = { name, us };
+}
+
+
+void BootStages::check(const char *what, uint32_t us, uint32_t budgetMs) const
+{
+    if (us > budgetMs * 1000)
+        log_w("%s after %.1f ms, over the budget of %u ms", what, us / 1000.0, budgetMs);
+}
+
+
+/**
+ * The first content is on the panel, only the first call counts
+*/
+void BootStages::firstPixel()
+{
+    if (_firstPixelUs) return;
+    mark("first pixel");
+    _firstPixelUs = esp_timer_get_time();
+    check("first pixel", _firstPixelUs, FIRST_PIXEL_BUDGET_MS);
+}
+
+
+/**
+ * The SD card is mounted and its catalog loaded
+*/
+void BootStages::sdReady()
+{
+    mark("sd ready");
+    _sdReadyUs = esp_timer_get_time();
+    check("SD card ready", _sdReadyUs, SD_READY_BUDGET_MS);
+}
+
+
+/**
+ * Print the stages in the order of their times
+*/
+void BootStages::print() const
+{
+    int n = _count < MAX_STAGES ? (int)_count : MAX_STAGES;
+    Stage sorted[MAX_STAGES];
+    for (int i = 0; i < n; i++)
+    {
+        int k = i;
+        while (k > 0 && sorted[k - 1].us > _stage[i].us)
+        {
+            sorted[k] = sorted[k - 1];
+            k--;
+        }
+        sorted[k] = _stage[i];
+    }
+
+    Serial.printf("\nBoot stages\n-----------\n");
+    uint32_t previous = 0;
+    for (int i = 0; i < n; i++)
+    {
+        Serial.printf("%-16s %8.1f ms  %+8.1f ms\n", sorted[i].name, 
+                      sorted[i].us / 1000.0, (sorted[i].us - previous) / 1000.0);
+        previous = sorted[i].us;
+    }
+    Serial.printf("time to first pixel %.1f ms (budget %u ms)%s\n", _firstPixelUs / 1000.0, 
+                  FIRST_PIXEL_BUDGET_MS, _firstPixelUs > FIRST_PIXEL_BUDGET_MS * 1000 ? "  OVER BUDGET" : "");
+    if (_sdReadyUs)
+        Serial.printf("SD card ready       %.1f ms (budget %u ms)%s\n", _sdReadyUs / 1000.0, 
+                      SD_READY_BUDGET_MS, _sdReadyUs > SD_READY_BUDGET_MS * 1000 ? "  OVER BUDGET" : "");
+    Serial.printf("\n");
+}
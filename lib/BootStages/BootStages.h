@@ -0,0 +1,48 @@
+/**
+ * Timestamps of the boot stages
+ * 
+ * Every stage of the start is marked with the time since the start 
+ * of the program (esp_timer), from setup() and from the background 
+ * task that mounts the SD card. The time until the first content (not 
+ * just the cleared screen) is on the panel and the time until the SD 
+ * card is ready are compared with their budgets, a stage over budget 
+ * is logged as warning so that a change that slows down the start is 
+ * noticed at once.
+ * 
+ * Usage    bootStages.mark("display");
+ *          bootStages.firstPixel();
+ *          ...
+ *          bootStages.print();
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+
+class BootStages
+{
+    public:
+        static constexpr int MAX_STAGES = 16;
+        static constexpr uint32_t FIRST_PIXEL_BUDGET_MS = 400;
+        static constexpr uint32_t SD_READY_BUDGET_MS = 2000;
+
+        void mark(const char *name);
+        void firstPixel();
+        void sdReady();
+        void print() const;
+
+    private:
+        void check(const char *what, uint32_t us, uint32_t budgetMs) const;
+
+        struct Stage
+        {
+            const char *name;
+            uint32_t us;
+        };
+        Stage _stage[MAX_STAGES];
+        std::atomic<int> _count{0};
+        uint32_t _firstPixelUs = 0;
+        uint32_t _sdReadyUs = 0;
+};
+
+extern BootStages bootStages;
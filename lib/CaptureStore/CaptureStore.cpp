@@ -0,0 +1,251 @@
+#include "CaptureStore.h"
+#include "SdCatalog.h"
+#include <time.h>
+
+CaptureStore captureStore;
+
+constexpr uint32_t JOURNAL_MAGIC = 0x4A504143;  // "CAPJ"
+constexpr uint16_t JOURNAL_VERSION = 2;
+static const char *CAPTURE_ROOT = "/captures";
+static const char *JOURNAL_PATH = "/captures/journal.bin";
+static const char *JOURNAL_TMP  = "/captures/journal.tmp";
+
+
+/**
+ * Open the journal for reading and writing, a new one is created 
+ * when it is missing or invalid
+*/
+bool CaptureStore::open()
+{
+    if (! SD.exists(JOURNAL_PATH) && SD.exists(JOURNAL_TMP)) 
+        SD.rename(JOURNAL_TMP, JOURNAL_PATH);     // crashed while compacting
+    _journal = SD.open(JOURNAL_PATH, "r+");
+    if (_journal && _journal.read((uint8_t*)&_header, sizeof(_header)) == sizeof(_header) 
+        && _header.magic == JOURNAL_MAGIC && _header.version == JOURNAL_VERSION)
+    {
+        _records = (_journal.size() - sizeof(Header)) / sizeof(Record);
+        return true;
+    }
+    if (_journal) _journal.close();
+
+    log_i("New capture journal");
+    _header = { JOURNAL_MAGIC, JOURNAL_VERSION, 0, 1 };
+    _records = 0;
+    File f = SD.open(JOURNAL_PATH, FILE_WRITE);
+    if (! f) return false;
+    f.write((uint8_t*)&_header, sizeof(_header));
+    f.close();
+    _journal = SD.open(JOURNAL_PATH, "r+");
+    return (bool)_journal;
+}
+
+
+bool CaptureStore::writeHeader()
+{
+    bool ok = _journal.seek(0) && _journal.write((uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+    _journal.flush();
+    return ok;
+}
+
+
+bool CaptureStore::writeRecord(int index, const Record &r)
+{
+    bool ok = _journal.seek(sizeof(Header) + index * sizeof(Record)) 
+              && _journal.write((const uint8_t*)&r, sizeof(r)) == sizeof(r);
+    _journal.flush();
+    return ok;
+}
+
+
+bool CaptureStore::readRecord(int index, Record &r)
+{
+    return _journal.seek(sizeof(Header) + index * sizeof(Record)) 
+           && _journal.read((uint8_t*)&r, sizeof(r)) == sizeof(r);
+}
+
+
+/**
+ * Read the journal, delete the files of captures that were not 
+ * completed and start a new session
+*/
+bool CaptureStore::begin()
+{
+    SD.mkdir(CAPTURE_ROOT);
+    if (! open())
+    {
+        log_e("%s can't be opened, captures are not saved", JOURNAL_PATH);
+        return false;
+    }
+
+    _first = _count = 0;
+    _bytes = 0;
+    int recovered = 0;
+    Record r;
+    for (int i = 0; i < _records && readRecord(i, r); i++)
+    {
+        r.path[PATH_LEN - 1] = '\0';
+        if (r.state == STATE::DONE && sdCatalog.find(r.path) != nullptr)
+        {
+            if (_count == MAX_FILES) dropOldest();
+            push({ r.sequence, r.size, (uint16_t)i });
+            continue;
+        }
+        if (r.state == STATE::DELETED) continue;
+        if (r.state == STATE::PENDING)
+        {
+            SD.remove(r.path);
+            sdCatalog.remove(r.path);
+            recovered++;
+        }
+        r.state = STATE::DELETED;
+        writeRecord(i, r);
+    }
+    if (recovered) log_e("%d incomplete captures deleted", recovered);
+
+    _header.session++;
+    writeHeader();
+    time_t now = time(nullptr);
+    struct tm t;
+    localtime_r(&now, &t);
+    if (t.tm_year + 1900 >= 2024)
+        snprintf(_dir, sizeof(_dir), "%s/%04d%02d%02d", CAPTURE_ROOT, t.tm_year + 1900, t.tm_mon + 1, t.tm_mday);
+    else
+        snprintf(_dir, sizeof(_dir), "%s/S%04u", CAPTURE_ROOT, _header.session);
+    _ready = true;
+    while (_count > maxFiles || _bytes > maxBytes) dropOldest();
+    if (_records > 2 * _count + 64) compact();
+    log_i("session %u, %d captures, %u KB", _header.session, _count, _bytes >> 10);
+    return true;
+}
+
+
+void CaptureStore::push(const Capture &c)
+{
+    _ring[(_first + _count) % MAX_FILES] = c;
+    _count++;
+    _bytes += c.size;
+}
+
+
+/**
+ * Delete the oldest capture, and its directory when it is empty
+*/
+void CaptureStore::dropOldest()
+{
+    if (_count == 0) return;
+    const Capture &c = _ring[_first];
+    _first = (_first + 1) % MAX_FILES;
+    _count--;
+    _bytes -= c.size;
+
+    Record r;
+    if (! readRecord(c.record, r)) return;
+    r.path[PATH_LEN - 1] = '\0';
+    SD.remove(r.path);
+    sdCatalog.remove(r.path);
+    r.state = STATE::DELETED;
+    writeRecord(c.record, r);
+
+    char *slash = strrchr(r.path, '/');
+    if (slash == nullptr) return;
+    *slash = '\0';
+    if (strcmp(r.path, _dir) != 0 && SD.rmdir(r.path)) sdCatalog.remove(r.path);
+}
+
+
+/**
+ * Rewrite the journal with the records of the kept captures only. 
+ * Their record indices change only when the new journal is in place.
+*/
+void CaptureStore::compact()
+{
+    File f = SD.open(JOURNAL_TMP, FILE_WRITE);
+    if (! f) return;
+    bool ok = f.write((uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+    Record r;
+    for (int k = 0; ok && k < _count; k++)
+    {
+        const Capture &c = _ring[(_first + k) % MAX_FILES];
+        ok = readRecord(c.record, r) && f.write((uint8_t*)&r, sizeof(r)) == sizeof(r);
+    }
+    f.close();
+    if (! ok)
+    {
+        SD.remove(JOURNAL_TMP);
+        return;
+    }
+    _journal.close();
+    SD.remove(JOURNAL_PATH);
+    if (! SD.rename(JOURNAL_TMP, JOURNAL_PATH))
+    {
+        // begin() takes the new journal at the next start
+        log_e("%s can't be renamed, captures are not saved", JOURNAL_TMP);
+        _ready = false;
+        return;
+    }
+    _journal = SD.open(JOURNAL_PATH, "r+");
+    for (int k = 0; k < _count; k++) _ring[(_first + k) % MAX_FILES].record = k;
+    log_i("capture journal compacted from %d to %d records", _records, _count);
+    _records = _count;
+}
+
+
+/**
+ * Save a capture with writer under the next sequence number. 
+ * name is the file name without directory and number.
+*/
+bool CaptureStore::save(LGFX &lcd, const char *name, Writer writer)
+{
+    if (! _ready) return false;
+
+    Record r = {};
+    r.sequence = _header.sequence;
+    r.state = STATE::PENDING;
+    if (snprintf(r.path, PATH_LEN, "%s/%06u_%s", _dir, r.sequence, name) >= PATH_LEN)
+    {
+        log_e("Name of the capture too long: %s", name);
+        return false;
+    }
+    if (sdCatalog.find(_dir) == nullptr)
+    {
+        SD.mkdir(_dir);
+        sdCatalog.update(_dir);
+    }
+
+    int index = _records;
+    if (! writeRecord(index, r)) return false;
+    _records++;
+    _header.sequence++;
+    writeHeader();
+
+    bool ok = writer(lcd, r.path);
+    sdCatalog.update(r.path);
+    const CatalogEntry *e = sdCatalog.find(r.path);
+    if (ok && e != nullptr)
+    {
+        r.size = e->size;
+        r.state = STATE::DONE;
+        writeRecord(index, r);
+        while (_count > 0 && (_count >= maxFiles || _bytes + r.size > maxBytes)) dropOldest();
+        push({ r.sequence, r.size, (uint16_t)index });
+    }
+    else
+    {
+        SD.remove(r.path);
+        sdCatalog.remove(r.path);
+        r.state = STATE::DELETED;
+        writeRecord(index, r);
+        ok = false;
+    }
+    if (_records > 2 * _count + 64) compact();
+    return ok;
+}
+
+
+void CaptureStore::print() const
+{
+    Serial.printf("\nsession %u, directory %s\n", _header.session, _dir);
+    Serial.printf("%d captures, %u KB, keeping %d files and %u MB\n", 
+                  _count, _bytes >> 10, maxFiles, maxBytes >> 20);
+    Serial.printf("next number %u, %d journal records\n\n", _header.sequence, _records);
+}
@@ -0,0 +1,92 @@
+/**
+ * Store for the screenshots
+ * 
+ * Every capture gets a new file with a sequence number in a directory 
+ * of the day (/captures/20240310) or, without a valid clock, of the 
+ * session (/captures/S0007), instead of overwriting the same files in 
+ * the root directory again and again:
+ * 
+ *          /captures/S0007/000123_11_Mandelbrot_16.bmp
+ * 
+ * The captures are kept in a ring: when there are more than maxFiles 
+ * or they need more than maxBytes, the oldest ones are deleted.
+ * 
+ * The journal /captures/journal.bin records each capture before its 
+ * file is written and marks it done when the file is complete. After 
+ * a crash, files that were not completed are deleted at the next 
+ * start. The journal is compacted when it holds many deleted records.
+ * 
+ * File       journal.bin: "CAPJ", version, session, next sequence number, 
+ *            then records of 128 bytes: sequence number, size, state, path
+ * 
+ * Usage    captureStore.begin();
+ *          captureStore.save(lcd, "11_Mandelbrot_16.bmp", saveBmpToSD_16bit);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+
+class CaptureStore
+{
+    public:
+        using Writer = bool(*)(LGFX &lcd, const char *path);
+        static constexpr int MAX_FILES = 256;
+        static constexpr int NAME_LEN = 64;       // of a capture name, with the '\0'
+        static constexpr int DIR_LEN = 32;
+        static constexpr int PATH_LEN = 116;      // directory, '/', number, '_', name
+
+        int      maxFiles = MAX_FILES;
+        uint32_t maxBytes = 64u << 20;
+
+        bool begin();
+        bool save(LGFX &lcd, const char *name, Writer writer);
+        void print() const;
+
+    private:
+        enum class STATE : uint8_t { PENDING, DONE, DELETED };
+        struct Header
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t session;
+            uint32_t sequence;    // next sequence number
+        };
+        struct Record
+        {
+            uint32_t sequence;
+            uint32_t size;
+            STATE    state;
+            uint8_t  reserved[3];
+            char     path[PATH_LEN];
+        };
+        static_assert(sizeof(Record) == 128, "journal records have 128 bytes");
+        static_assert(PATH_LEN >= DIR_LEN + 12 + NAME_LEN, "the path of the longest name fits");
+        struct Capture
+        {
+            uint32_t sequence;
+            uint32_t size;
+            uint16_t record;      // index of the record in the journal
+        };
+
+        bool open();
+        bool writeHeader();
+        bool writeRecord(int index, const Record &r);
+        bool readRecord(int index, Record &r);
+        void push(const Capture &c);
+        void dropOldest();
+        void compact();
+
+        File     _journal;          // kept open, flushed after every change
+        Header   _header = {};
+        char     _dir[DIR_LEN] = "";
+        int      _records = 0;      // in the journal
+        Capture  _ring[MAX_FILES];
+        int      _first = 0, _count = 0;
+        uint32_t _bytes = 0;
+        bool     _ready = false;
+};
+
+extern CaptureStore captureStore;
@@ -0,0 +1,233 @@
+#include "DisplayList.h"
+#include "RenderStats.h"
+
+void DisplayList::begin(int width, int height)
+{
+    _count  = 0;
+    _width  = width;
+    _height = height;
+    _stats  = {};
+}
+
+
+/**
+ * Add a primitive. Rectangle outlines, straight lines, pixels and 
+ * fillScreen are normalized to filled rectangles right away.
+*/
+void DisplayList::add(OP op, uint16_t c, int16_t a0, int16_t a1, int16_t a2, int16_t a3)
+{
+    _stats.in++;
+    switch (op)
+    {
+        case OP_PIXEL:    pushRect(a0, a1, 1, 1, c); break;
+        case OP_HLINE:    pushRect(a0, a1, a2, 1, c); break;
+        case OP_VLINE:    pushRect(a0, a1, 1, a2, c); break;
+        case OP_FILLRECT: pushRect(a0, a1, a2, a3, c); break;
+        case OP_SCREEN:   pushRect(0, 0, _width, _height, c); break;
+        case OP_RECT:
+            if (a2 < 3 || a3 < 3) { pushRect(a0, a1, a2, a3, c); break; }  // no inner area
+            pushRect(a0,          a1,          a2, 1,      c);
+            pushRect(a0,          a1 + a3 - 1, a2, 1,      c);
+            pushRect(a0,          a1 + 1,      1,  a3 - 2, c);
+            pushRect(a0 + a2 - 1, a1 + 1,      1,  a3 - 2, c);
+            break;
+        case OP_LINE:
+            if (a1 == a3)      pushRect(std::min(a0, a2), a1, abs(a2 - a0) + 1, 1, c);
+            else if (a0 == a2) pushRect(a0, std::min(a1, a3), 1, abs(a3 - a1) + 1, c);
+            else               push(op, c, a0, a1, a2, a3);
+            break;
+        default: push(op, c, a0, a1, a2, a3); break;
+    }
+}
+
+
+void DisplayList::push(OP op, uint16_t c, int16_t a0, int16_t a1, int16_t a2, int16_t a3)
+{
+    if (_count == _capacity)
+    {
+        log_w("display list full, %d commands", _capacity);
+        return;
+    }
+    DrawCmd &cmd = _cmd[_count++];
+    cmd.op = op;
+    cmd.color = c;
+    cmd.arg[0] = a0; cmd.arg[1] = a1; cmd.arg[2] = a2; cmd.arg[3] = a3;
+}
+
+
+void DisplayList::pushRect(int x, int y, int w, int h, uint16_t c)
+{
+    if (w < 0) { x += w + 1; w = -w; }
+    if (h < 0) { y += h + 1; h = -h; }
+    if (w == 0 || h == 0) return;
+    push(OP_FILLRECT, c, x, y, w, h);
+}
+
+
+DisplayList::Box DisplayList::box(const DrawCmd &c)
+{
+    const int16_t *a = c.arg;
+    switch (c.op)
+    {
+        case OP_FILLRECT:   return { a[0], a[1], a[2], a[3] };
+        case OP_CIRCLE:
+        case OP_FILLCIRCLE: return { (int16_t)(a[0] - a[2]), (int16_t)(a[1] - a[2]), (int16_t)(2*a[2] + 1), (int16_t)(2*a[2] + 1) };
+        case OP_LINE:       return { std::min(a[0], a[2]), std::min(a[1], a[3]), 
+                                     (int16_t)(abs(a[2] - a[0]) + 1), (int16_t)(abs(a[3] - a[1]) + 1) };
+        default:            return { 0, 0, 0x7FFF, 0x7FFF };  // unknown, overlaps everything
+    }
+}
+
+
+/**
+ * True if the filled command top hides the whole box b
+*/
+bool DisplayList::covers(const DrawCmd &top, const Box &b)
+{
+    const int16_t *a = top.arg;
+    if (top.op == OP_FILLRECT)
+        return b.x >= a[0] && b.y >= a[1] && b.x + b.w <= a[0] + a[2] && b.y + b.h <= a[1] + a[3];
+
+    if (top.op == OP_FILLCIRCLE)    // the disc is convex, so it is enough to check the corners
+    {
+        int32_t r2 = a[2] * a[2];
+        int32_t x[] = { b.x - a[0], b.x + b.w - 1 - a[0] };
+        int32_t y[] = { b.y - a[1], b.y + b.h - 1 - a[1] };
+        for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 2; j++)
+                if (x[i]*x[i] + y[j]*y[j] > r2) return false;
+        return true;
+    }
+    return false;
+}
+
+
+bool DisplayList::disjoint(const Box &a, const Box &b)
+{
+    return a.x + a.w <= b.x || b.x + b.w <= a.x || a.y + a.h <= b.y || b.y + b.h <= a.y;
+}
+
+
+/**
+ * Merge the filled rectangle b into a if both have the same color 
+ * and their union is a rectangle. Returns true if merged.
+*/
+bool DisplayList::merge(DrawCmd &a, const DrawCmd &b)
+{
+    if (a.op != OP_FILLRECT || b.op != OP_FILLRECT || a.color != b.color) return false;
+    int16_t *p = a.arg;
+    const int16_t *q = b.arg;
+
+    if (p[0] == q[0] && p[2] == q[2] && q[1] <= p[1] + p[3] && p[1] <= q[1] + q[3])  // same columns, touching rows
+    {
+        int16_t y0 = std::min(p[1], q[1]);
+        p[3] = std::max(p[1] + p[3], q[1] + q[3]) - y0;
+        p[1] = y0;
+        return true;
+    }
+    if (p[1] == q[1] && p[3] == q[3] && q[0] <= p[0] + p[2] && p[0] <= q[0] + q[2])  // same rows, touching columns
+    {
+        int16_t x0 = std::min(p[0], q[0]);
+        p[2] = std::max(p[0] + p[2], q[0] + q[2]) - x0;
+        p[0] = x0;
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Remove the commands covered by a later filled rectangle or circle
+*/
+void DisplayList::cull()
+{
+    int n = 0;
+    for (int i = 0; i < _count; i++)
+    {
+        Box b = box(_cmd[i]);
+        bool isHidden = false;
+        for (int j = i + 1; j < _count && ! isHidden; j++) isHidden = covers(_cmd[j], b);
+        if (isHidden) _stats.culled++;
+        else          _cmd[n++] = _cmd[i];
+    }
+    _count = n;
+}
+
+
+/**
+ * Insertion sort by column range and row. A command only moves 
+ * past commands whose area it does not overlap.
+*/
+void DisplayList::sort()
+{
+    auto less = [](const Box &a, const Box &b) 
+    { 
+        if (a.x != b.x) return a.x < b.x;
+        if (a.w != b.w) return a.w < b.w;
+        return a.y < b.y;
+    };
+    for (int i = 1; i < _count; i++)
+    {
+        DrawCmd c = _cmd[i];
+        Box b = box(c);
+        int j = i;
+        while (j > 0)
+        {
+            Box p = box(_cmd[j - 1]);
+            if (! less(b, p) || ! disjoint(b, p)) break;
+            _cmd[j] = _cmd[j - 1];
+            j--;
+        }
+        _cmd[j] = c;
+    }
+}
+
+
+void DisplayList::mergeRects()
+{
+    if (_count == 0) return;
+    int n = 1;
+    for (int i = 1; i < _count; i++)
+    {
+        if (merge(_cmd[n - 1], _cmd[i])) _stats.merged++;
+        else _cmd[n++] = _cmd[i];
+    }
+    _count = n;
+}
+
+
+void DisplayList::compile()
+{
+    cull();
+    sort();
+    mergeRects();
+}
+
+
+/**
+ * Compile the list, send it to the lcd in one transaction and clear it.
+ * Thin rectangles are sent as fast lines or pixels. The statistics 
+ * of the frame stay available until the next begin().
+*/
+void DisplayList::flush(LGFX &lcd)
+{
+    compile();
+    lcd.startWrite();
+    for (int i = 0; i < _count; i++)
+    {
+        DrawCmd &c = _cmd[i];
+        if (c.op == OP_FILLRECT)
+        {
+            const int16_t *a = c.arg;
+            if      (a[2] == 1 && a[3] == 1) c.op = OP_PIXEL;
+            else if (a[3] == 1)              c.op = OP_HLINE;
+            else if (a[2] == 1)              { c.op = OP_VLINE; c.arg[2] = a[3]; }
+        }
+        execute(lcd, c);
+    }
+    lcd.endWrite();
+    _stats.out = _count;
+    renderCounters.listIn  += _stats.in;
+    renderCounters.listOut += _stats.out;
+    _count = 0;
+}
@@ -0,0 +1,90 @@
+/**
+ * Retained display list
+ * 
+ * Collects draw commands (see DrawCmd.h) instead of sending them to 
+ * the lcd at once. Before the list is flushed, it is compiled:
+ *  - rectangle outlines become 4 fast lines, horizontal and vertical 
+ *    lines, pixels and fillScreen become filled rectangles
+ *  - commands completely covered by a later filled rectangle or 
+ *    filled circle are removed
+ *  - commands with disjoint areas are sorted by their column range, 
+ *    so the panel can keep its column address (CASET) and adjacent 
+ *    filled rectangles of the same color come together
+ *  - adjacent or overlapping rectangles of the same color are merged
+ * The order of overlapping commands is never changed.
+ * 
+ * Usage    StaticDisplayList<64> dl;
+ *          dl.begin(lcd.width(), lcd.height());
+ *          dl.drawRect(0, 0, 100, 50, TFT_RED);
+ *          ...
+ *          dl.flush(lcd);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "DrawCmd.h"
+
+struct DisplayListStats
+{
+    uint32_t in;      // primitives added
+    uint32_t out;     // primitives sent to the lcd
+    uint32_t culled;  // removed because covered
+    uint32_t merged;  // removed by merging
+};
+
+class DisplayList
+{
+    public:
+        DisplayList(DrawCmd *buf, int capacity) : _cmd(buf), _capacity(capacity) {}
+
+        void begin(int width, int height);
+        void compile();
+        void flush(LGFX &lcd);
+        const DisplayListStats &stats() const { return _stats; }
+
+        void drawPixel(int x, int y, uint16_t c)                         { add(OP_PIXEL, c, x, y); }
+        void drawLine(int x0, int y0, int x1, int y1, uint16_t c)        { add(OP_LINE, c, x0, y0, x1, y1); }
+        void drawFastHLine(int x, int y, int w, uint16_t c)              { add(OP_HLINE, c, x, y, w); }
+        void drawFastVLine(int x, int y, int h, uint16_t c)              { add(OP_VLINE, c, x, y, h); }
+        void drawRect(int x, int y, int w, int h, uint16_t c)            { add(OP_RECT, c, x, y, w, h); }
+        void fillRect(int x, int y, int w, int h, uint16_t c)            { add(OP_FILLRECT, c, x, y, w, h); }
+        void drawCircle(int x, int y, int r, uint16_t c)                 { add(OP_CIRCLE, c, x, y, r); }
+        void fillCircle(int x, int y, int r, uint16_t c)                 { add(OP_FILLCIRCLE, c, x, y, r); }
+        void fillScreen(uint16_t c)                                      { add(OP_SCREEN, c); }
+
+    private:
+        struct Box { int16_t x, y, w, h; };
+
+        void add(OP op, uint16_t c, int16_t a0 = 0, int16_t a1 = 0, int16_t a2 = 0, int16_t a3 = 0);
+        void push(OP op, uint16_t c, int16_t a0, int16_t a1, int16_t a2 = 0, int16_t a3 = 0);
+        void pushRect(int x, int y, int w, int h, uint16_t c);
+        static Box box(const DrawCmd &c);
+        static bool covers(const DrawCmd &top, const Box &b);
+        static bool disjoint(const Box &a, const Box &b);
+        static bool merge(DrawCmd &a, const DrawCmd &b);
+        void cull();
+        void sort();
+        void mergeRects();
+
+        DrawCmd *_cmd;
+        int      _capacity;
+        int      _count = 0;
+        int      _width = 0;
+        int      _height = 0;
+        DisplayListStats _stats = {};
+};
+
+
+/**
+ * Display list with its own storage for N commands
+*/
+template<int N> class StaticDisplayList : public DisplayList
+{
+    public:
+        StaticDisplayList() : DisplayList(_buf, N) {}
+
+    private:
+        DrawCmd _buf[N];
+};
@@ -0,0 +1,95 @@
+#include <SD.h>
+#include "DrawProfiler.h"
+#include "SdCatalog.h"
+
+DrawProfiler drawProfiler;
+
+const char *DrawProfiler::name(PRIM p)
+{
+    static const char *names[PRIM_COUNT] = { 
+        "pixel", "line", "hline", "vline", "rect", "fillRect", 
+        "roundRect", "circle", "fillCircle", "triangle", "fillTriangle",
+        "gradient", "image", "imageDMA", "text", "screen", "read" 
+    };
+    return p < PRIM_COUNT ? names[p] : "?";
+}
+
+
+void DrawProfiler::add(PRIM p, uint32_t pixels, uint32_t windows, uint32_t bytesPerPixel, uint32_t cycles)
+{
+    uint32_t bytes = pixels * bytesPerPixel + windows * WINDOW_BYTES;
+    PrimProfile &pp = _prim[p];
+    pp.calls++;
+    pp.pixels   += pixels;
+    pp.spiBytes += bytes;
+    pp.cycles   += cycles;
+    if (p != PRIM_READ) renderCounters.add(pixels * bytesPerPixel);
+}
+
+
+/**
+ * Output the profile of an activity to the selected destination
+*/
+void DrawProfiler::dump(const char *activity)
+{
+    switch (_out)
+    {
+        case PROFILE_OUT::CONSOLE: print(activity); break;
+        case PROFILE_OUT::CARD:    appendCSV("/profile.csv", activity); break;
+        default: break;
+    }
+}
+
+
+/**
+ * Print the primitives used by an activity, 
+ * the share of the cycles spent in each of them
+*/
+void DrawProfiler::print(const char *activity)
+{
+    uint64_t total = 0;
+    for (int i = 0; i < PRIM_COUNT; i++) total += _prim[i].cycles;
+    if (total == 0) total = 1;
+
+    Serial.printf("\nProfile %s\n", activity);
+    Serial.printf("primitive        calls     pixels   spi bytes        ms      %%\n");
+    for (int i = 0; i < PRIM_COUNT; i++)
+    {
+        const PrimProfile &pp = _prim[i];
+        if (pp.calls == 0) continue;
+        Serial.printf("%-12s %9u %10u %11u %9.1f %6.1f\n", name((PRIM)i), pp.calls, pp.pixels, pp.spiBytes, 
+                      pp.cycles / (getCpuFrequencyMhz() * 1000.0), 100.0 * pp.cycles / total);
+    }
+    if (_prim[PRIM_IMAGE_DMA].calls) 
+        Serial.printf("imageDMA: time to start the transfers only, they run in the background\n");
+}
+
+
+/**
+ * Append one line per used primitive to a CSV file on the SD card.
+ * The header line is written when the file is created.
+*/
+bool DrawProfiler::appendCSV(const char *path, const char *activity)
+{
+    bool isNew = ! SD.exists(path);
+    File file = SD.open(path, FILE_APPEND);
+    if (! file) 
+    {
+        log_e("==> %s can't be opened", path);
+        return false;
+    }
+    if (isNew) file.print("activity,primitive,calls,pixels,spi_bytes,cycles\n");
+
+    char line[96];
+    for (int i = 0; i < PRIM_COUNT; i++)
+    {
+        const PrimProfile &pp = _prim[i];
+        if (pp.calls == 0) continue;
+        snprintf(line, sizeof(line), "%s,%s,%u,%u,%u,%llu\n", activity, name((PRIM)i), 
+                 pp.calls, pp.pixels, pp.spiBytes, pp.cycles);
+        file.print(line);
+    }
+    file.close();
+    sdCatalog.update(path);
+    return true;
+}
@@ -0,0 +1,103 @@
+/**
+ * Profiler for the draw calls of the LGFX class
+ * 
+ * When the build flag LGFX_PROFILE is defined, the LGFX class in 
+ * lgfx_ESP32_2432S028.h hides the draw calls of LGFX_Device with 
+ * instrumented versions. Each of them places a DrawProbe on the stack,
+ * which counts the call, the pixels drawn and the estimated SPI bytes 
+ * and measures the CPU cycles spent until the call returns.
+ * Without LGFX_PROFILE the original calls are used and nothing is measured.
+ * 
+ * The SPI bytes are estimated as 2 bytes per pixel plus 11 bytes 
+ * (CASET, RASET, RAMWR with their parameters) per address window.
+ * Read calls transfer 3 bytes per pixel.
+ * 
+ * pushImageDMA() is profiled as imageDMA. It returns as soon as the 
+ * transfer is started, so its cycles are the setup of the transfer 
+ * only, the transfer itself overlaps with the code that follows.
+ * 
+ * Every profiled call except reads is also added to the render 
+ * counters, the render paths don't add their pushes again then.
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <esp_idf_version.h>
+#include "RenderStats.h"
+#if ESP_IDF_VERSION_MAJOR >= 5
+#include <esp_cpu.h>
+#endif
+
+enum PRIM : uint8_t { PRIM_PIXEL, PRIM_LINE, PRIM_HLINE, PRIM_VLINE, PRIM_RECT, PRIM_FILLRECT,
+                      PRIM_ROUNDRECT, PRIM_CIRCLE, PRIM_FILLCIRCLE, PRIM_TRIANGLE, PRIM_FILLTRIANGLE,
+                      PRIM_GRADIENT, PRIM_IMAGE, PRIM_IMAGE_DMA, PRIM_TEXT, PRIM_SCREEN, PRIM_READ, 
+                      PRIM_COUNT 
+                    };
+
+struct PrimProfile
+{
+    uint32_t calls;
+    uint32_t pixels;
+    uint32_t spiBytes;
+    uint64_t cycles;
+};
+
+enum class PROFILE_OUT : uint8_t { OFF, CONSOLE, CARD };
+
+class DrawProfiler
+{
+    public:
+        static constexpr uint32_t WINDOW_BYTES = 11;  // CASET + 4, RASET + 4, RAMWR
+
+        void reset() { memset(_prim, 0, sizeof(_prim)); }
+        void add(PRIM p, uint32_t pixels, uint32_t windows, uint32_t bytesPerPixel, uint32_t cycles);
+        void output(PROFILE_OUT out) { _out = out; }
+        PROFILE_OUT output() const { return _out; }
+        void dump(const char *activity);
+        void print(const char *activity);
+        bool appendCSV(const char *path, const char *activity);
+        const PrimProfile &operator[](PRIM p) const { return _prim[p]; }
+        static const char *name(PRIM p);
+
+        static uint32_t cycleCount()
+        {
+        #if ESP_IDF_VERSION_MAJOR >= 5
+            return esp_cpu_get_cycle_count();
+        #else
+            return ESP.getCycleCount();   // esp_cpu_get_cycle_count() exists since IDF 5
+        #endif
+        }
+
+        // Pixels and address windows LovyanGFX needs for a line
+        static uint32_t linePixels(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+        { return std::max(abs(x1 - x0), abs(y1 - y0)) + 1; }
+        static uint32_t lineWindows(int32_t x0, int32_t y0, int32_t x1, int32_t y1)
+        { return std::min(abs(x1 - x0), abs(y1 - y0)) + 1; }
+
+    private:
+        PrimProfile _prim[PRIM_COUNT];
+        PROFILE_OUT _out = PROFILE_OUT::CONSOLE;
+};
+
+extern DrawProfiler drawProfiler;
+
+
+/**
+ * Measures one draw call from its construction to the end of the scope
+*/
+class DrawProbe
+{
+    public:
+        DrawProbe(PRIM p, uint32_t pixels, uint32_t windows = 1, uint32_t bytesPerPixel = 2) : 
+            _prim(p), _pixels(pixels), _windows(windows), _bytesPerPixel(bytesPerPixel), 
+            _start(DrawProfiler::cycleCount()) {}
+        ~DrawProbe() 
+        { drawProfiler.add(_prim, _pixels, _windows, _bytesPerPixel, DrawProfiler::cycleCount() - _start); }
+
+    private:
+        PRIM     _prim;
+        uint32_t _pixels;
+        uint32_t _windows;
+        uint32_t _bytesPerPixel;
+        uint32_t _start;
+};
@@ -0,0 +1,64 @@
+/**
+ * Draw commands
+ * 
+ * A draw command is one LGFX primitive call with its color and up to
+ * 6 integer arguments. The same encoding is used by the trace files 
+ * of DrawTrace and by retained display lists.
+ * 
+ * Encoding   op (1 byte), color (2 bytes RGB565), args (2 bytes each)
+ *            all values little endian. OP_IMAGE and OP_STRING are 
+ *            followed by their pixels resp. characters.
+*/
+
+#pragma once
+#include <stdint.h>
+
+enum OP : uint8_t { OP_PIXEL, OP_LINE, OP_HLINE, OP_VLINE, OP_RECT, OP_FILLRECT, 
+                    OP_ROUNDRECT, OP_FILLROUNDRECT, OP_CIRCLE, OP_FILLCIRCLE, 
+                    OP_TRIANGLE, OP_FILLTRIANGLE, OP_SCREEN, OP_CHAR, OP_ROTATION,
+                    OP_IMAGE,     // x, y, w, h followed by w*h byte swapped RGB565 pixels
+                    OP_STRING,    // x, y, len followed by len characters
+                    OP_COUNT,
+                    OP_END = 0xFF 
+                  };
+
+// Number of arguments of each command
+constexpr uint8_t opArgs[OP_COUNT] = { 2, 4, 3, 3, 4, 4, 5, 5, 3, 3, 6, 6, 0, 3, 1, 4, 3 };
+
+struct DrawCmd
+{
+    OP       op;
+    uint16_t color;
+    int16_t  arg[6];
+};
+
+
+/**
+ * Execute a command with a fixed number of arguments on a target, 
+ * which can be the lcd, a sprite or any class with the same draw calls.
+ * Returns false for commands with additional data.
+*/
+template<class Target> bool execute(Target &t, const DrawCmd &c)
+{
+    const int16_t *a = c.arg;
+    switch (c.op)
+    {
+        case OP_PIXEL:         t.drawPixel(a[0], a[1], c.color); break;
+        case OP_LINE:          t.drawLine(a[0], a[1], a[2], a[3], c.color); break;
+        case OP_HLINE:         t.drawFastHLine(a[0], a[1], a[2], c.color); break;
+        case OP_VLINE:         t.drawFastVLine(a[0], a[1], a[2], c.color); break;
+        case OP_RECT:          t.drawRect(a[0], a[1], a[2], a[3], c.color); break;
+        case OP_FILLRECT:      t.fillRect(a[0], a[1], a[2], a[3], c.color); break;
+        case OP_ROUNDRECT:     t.drawRoundRect(a[0], a[1], a[2], a[3], a[4], c.color); break;
+        case OP_FILLROUNDRECT: t.fillRoundRect(a[0], a[1], a[2], a[3], a[4], c.color); break;
+        case OP_CIRCLE:        t.drawCircle(a[0], a[1], a[2], c.color); break;
+        case OP_FILLCIRCLE:    t.fillCircle(a[0], a[1], a[2], c.color); break;
+        case OP_TRIANGLE:      t.drawTriangle(a[0], a[1], a[2], a[3], a[4], a[5], c.color); break;
+        case OP_FILLTRIANGLE:  t.fillTriangle(a[0], a[1], a[2], a[3], a[4], a[5], c.color); break;
+        case OP_SCREEN:        t.fillScreen(c.color); break;
+        case OP_CHAR:          t.drawChar(a[0], a[1], a[2]); break;
+        case OP_ROTATION:      t.setRotation(a[0]); break;
+        default: return false;
+    }
+    return true;
+}
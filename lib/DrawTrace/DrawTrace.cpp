@@ -0,0 +1,103 @@
+#include "DrawTrace.h"
+
+DrawTrace drawTrace;
+
+/**
+ * Start recording to the file path. Seed is the random seed 
+ * the activity runs with, width and height the screen size.
+*/
+bool DrawTrace::begin(const char *path, uint32_t seed, uint16_t width, uint16_t height)
+{
+    _file = SD.open(path, FILE_WRITE);
+    if (! _file)
+    {
+        log_e("==> %s can't be opened", path);
+        return false;
+    }
+    _len = 0;
+    _commands = 0;
+    write(&MAGIC, 4);
+    write(&seed, 4);
+    write(&width, 2);
+    write(&height, 2);
+    _isRecording = true;
+    return true;
+}
+
+
+void DrawTrace::end()
+{
+    if (! _isRecording) return;
+    uint8_t op = OP_END;
+    write(&op, 1);
+    flush();
+    _file.close();
+    _isRecording = false;
+}
+
+
+void DrawTrace::write(const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    while (len > 0)
+    {
+        size_t n = std::min(len, sizeof(_buf) - _len);
+        memcpy(_buf + _len, p, n);
+        _len += n;
+        p    += n;
+        len  -= n;
+        if (_len == sizeof(_buf)) flush();
+    }
+}
+
+
+void DrawTrace::flush()
+{
+    if (_len > 0) _file.write(_buf, _len);
+    _len = 0;
+}
+
+
+void DrawTrace::record(OP op, uint16_t color, std::initializer_list<int32_t> args)
+{
+    uint8_t rec[1 + 2 + 2 * 6];
+    int n = 0;
+    rec[n++] = op;
+    rec[n++] = color;
+    rec[n++] = color >> 8;
+    for (int32_t a : args)
+    {
+        rec[n++] = a;
+        rec[n++] = a >> 8;
+    }
+    write(rec, n);
+    _commands++;
+}
+
+
+/**
+ * Record an image. The pixels are stored byte swapped, 
+ * isSwapped tells whether they are already in this order.
+*/
+void DrawTrace::recordImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, bool isSwapped)
+{
+    record(OP_IMAGE, 0, {x, y, w, h});
+    if (isSwapped)
+    {
+        write(pixels, 2 * w * h);
+        return;
+    }
+    for (int32_t i = 0; i < w * h; i++)
+    {
+        uint16_t c = (pixels[i] << 8) | (pixels[i] >> 8);
+        write(&c, 2);
+    }
+}
+
+
+void DrawTrace::recordString(int32_t x, int32_t y, const char *str)
+{
+    int32_t len = std::min<size_t>(strlen(str), 255);    // replay() reads at most 255
+    record(OP_STRING, 0, {x, y, len});
+    write(str, len);
+}
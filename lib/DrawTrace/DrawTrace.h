@@ -0,0 +1,140 @@
+/**
+ * Trace recorder and replayer for draw command streams
+ * 
+ * When the build flag LGFX_TRACE is defined, the draw calls of the LGFX 
+ * class in lgfx_ESP32_2432S028.h are passed to drawTrace, which writes 
+ * them as compact commands (see DrawCmd.h) to a file while recording.
+ * The header of the file holds the random seed the activity was run 
+ * with, so the generator can be rerun as well.
+ * 
+ * A trace is replayed on any target with the LGFX draw calls and
+ * startWrite()/endWrite(), e.g. the lcd, an off-screen LGFX_Sprite 
+ * or a stand-in on the host. The source only needs a method
+ * read(uint8_t *buf, size_t len) like the class File.
+ * 
+ * File       "DLT1", seed (4 bytes), width, height (2 bytes each), commands ..., OP_END
+ *
+ * Text is recorded as characters and positions only: OP_CHAR and
+ * OP_STRING are replayed with the font, text color and datum the target
+ * has at that time. Images are at most 320 pixels wide and strings at
+ * most 255 characters long, longer ones make the trace invalid.
+ * 
+ * Usage      drawTrace.begin("/traces/09.dlt", seed);
+ *            randomDots(lcd);
+ *            drawTrace.end();
+ *            ...
+ *            File f = SD.open("/traces/09.dlt");
+ *            DrawTrace::replay(f, lcd);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include <LovyanGFX.hpp>
+#include <initializer_list>
+#include "DrawCmd.h"
+
+struct TraceInfo
+{
+    uint32_t seed;
+    uint16_t width;
+    uint16_t height;
+    uint32_t commands;
+};
+
+class DrawTrace
+{
+    public:
+        static constexpr uint32_t MAGIC = 0x31544C44;  // "DLT1"
+
+        bool begin(const char *path, uint32_t seed, uint16_t width, uint16_t height);
+        void end();
+        bool isRecording() const { return _isRecording; }
+        uint32_t commands() const { return _commands; }
+
+        void record(OP op, uint16_t color, std::initializer_list<int32_t> args);
+        void recordImage(int32_t x, int32_t y, int32_t w, int32_t h, const uint16_t *pixels, bool isSwapped);
+        void recordString(int32_t x, int32_t y, const char *str);
+
+        template<typename T> static uint16_t color(const T &c) { return static_cast<uint16_t>(c); }
+        static bool isSwapped(const lgfx::swap565_t *) { return true; }
+        template<typename T> static bool isSwapped(const T *) { return false; }
+
+        template<class Source, class Target> static bool replay(Source &src, Target &target, TraceInfo *info = nullptr);
+
+    private:
+        void write(const void *data, size_t len);
+        void flush();
+
+        File     _file;
+        bool     _isRecording = false;
+        uint32_t _commands = 0;
+        size_t   _len = 0;
+        uint8_t  _buf[512];
+};
+
+extern DrawTrace drawTrace;
+
+
+/**
+ * Read a trace from src and execute its commands on the target.
+ * Returns false if the source is not a trace or ends unexpectedly.
+*/
+template<class Source, class Target> bool DrawTrace::replay(Source &src, Target &target, TraceInfo *info)
+{
+    uint8_t  hdr[12];
+    uint32_t magic;
+    TraceInfo ti = {};
+
+    if (src.read(hdr, sizeof(hdr)) != sizeof(hdr)) return false;
+    memcpy(&magic, hdr, 4);
+    if (magic != MAGIC) return false;
+    memcpy(&ti.seed,   hdr + 4, 4);
+    memcpy(&ti.width,  hdr + 8, 2);
+    memcpy(&ti.height, hdr + 10, 2);
+
+    bool isOk = true;
+    target.startWrite();
+    while (true)
+    {
+        uint8_t rec[1 + 2 + 2 * 6];
+        if (src.read(rec, 1) != 1 || rec[0] == OP_END) break;
+        OP op = (OP)rec[0];
+        if (op >= OP_COUNT) { isOk = false; break; }
+
+        size_t n = 2 + 2 * opArgs[op];
+        if (src.read(rec + 1, n) != n) { isOk = false; break; }
+        DrawCmd cmd;
+        cmd.op    = op;
+        cmd.color = rec[1] | (rec[2] << 8);
+        for (int i = 0; i < opArgs[op]; i++) cmd.arg[i] = rec[3 + 2*i] | (rec[4 + 2*i] << 8);
+        ti.commands++;
+
+        if (execute(target, cmd)) continue;
+
+        if (op == OP_IMAGE)         // pushed row by row
+        {
+            uint16_t line[320];
+            const int w = cmd.arg[2], h = cmd.arg[3];
+            if (w <= 0 || w > 320 || h < 0) { isOk = false; break; }
+            for (int y = 0; y < h; y++)
+            {
+                if (src.read((uint8_t*)line, 2 * w) != (size_t)(2 * w)) { isOk = false; break; }
+                target.pushImage(cmd.arg[0], cmd.arg[1] + y, w, 1, (lgfx::swap565_t*)line);
+            }
+        }
+        else if (op == OP_STRING)
+        {
+            char str[256];
+            const int len = cmd.arg[2];
+            if (len < 0 || len >= (int)sizeof(str)) { isOk = false; break; }
+            if (src.read((uint8_t*)str, len) != (size_t)len) { isOk = false; break; }
+            str[len] = '\0';
+            target.drawString(str, cmd.arg[0], cmd.arg[1]);
+        }
+        if (! isOk) break;
+    }
+    target.endWrite();
+    if (info) *info = ti;
+    return isOk;
+}
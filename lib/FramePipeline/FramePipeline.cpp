@@ -0,0 +1,118 @@
+#include "FramePipeline.h"
+#include "RenderStats.h"
+#include "Arena.h"
+#include "Hud.h"
+#include <math.h>
+
+FrameStats frameStats;
+int FramePipeline::targetFps = 20;
+
+
+void FramePipeline::waitUntil(uint32_t us)
+{
+    while ((int32_t)(us - micros()) > 2000) delay(1);
+    while ((int32_t)(us - micros()) > 0) ;
+}
+
+
+/**
+ * Show frames 0 .. frames-1 at the target rate. The band sprites use 
+ * buffers of the frame arena, or the heap when the arena is full.
+ * Without memory for them only the last frame is drawn directly to 
+ * the lcd.
+*/
+void FramePipeline::run(int frames, Render render, void *ctx, uint16_t background)
+{
+    const int w = _lcd.width();
+    const int h = _lcd.height();
+    const uint32_t period = 1000000 / (targetFps > 0 ? targetFps : 1);
+    LGFX_Sprite band0(&_lcd), band1(&_lcd);
+    LGFX_Sprite *band[2] = { &band0, &band1 };
+    ArenaScope scope(frameArena);
+
+    frameStats = FrameStats();
+    frameStats.targetUs = period;
+    if (frames <= 0) return;
+    for (int i = 0; i < 2; i++)
+    {
+        band[i]->setColorDepth(16);
+        uint16_t *buf = frameArena.alloc<uint16_t>(w * BAND_ROWS);
+        if (buf != nullptr) band[i]->setBuffer(buf, w, BAND_ROWS);
+        else if (band[i]->createSprite(w, BAND_ROWS) == nullptr)
+        {
+            log_e("No memory for the band sprites, drawing the last frame only");
+            band0.deleteSprite();
+            _lcd.fillScreen(background);
+            render(_lcd, 0, frames - 1, ctx);
+            return;
+        }
+    }
+
+    uint64_t sumUs = 0, sumSquares = 0, renderUs = 0;
+    uint32_t first = micros(), previous = first, deadline = first;
+    int current = 0;
+
+    _lcd.startWrite();
+    for (int n = 0; n < frames; n++)
+    {
+        uint32_t late = micros() - deadline;
+        if ((int32_t)late >= (int32_t)period && n < frames - 1)
+        {
+            int skip = late / period;
+            if (n + skip > frames - 1) skip = frames - 1 - n;
+            n += skip;
+            deadline += skip * period;
+            frameStats.dropped += skip;
+        }
+        waitUntil(deadline);
+
+        uint32_t start = micros();
+        if (frameStats.frames > 0)
+        {
+            uint32_t interval = start - previous;
+            sumUs += interval;
+            sumSquares += (uint64_t)interval * interval;
+        }
+        previous = start;
+
+        for (int y0 = 0; y0 < h; y0 += BAND_ROWS)
+        {
+            LGFX_Sprite &b = *band[current];
+            int rows = h - y0 < BAND_ROWS ? h - y0 : BAND_ROWS;
+            b.fillScreen(background);
+            render(b, y0, n, ctx);
+            hud.overlay((uint16_t*)b.getBuffer(), w, y0, rows);
+            _lcd.pushImageDMA(0, y0, w, rows, (lgfx::swap565_t*)b.getBuffer());
+            renderCounters.addPush(2 * w * rows);
+            current ^= 1;
+        }
+        renderUs += micros() - start;
+        frameStats.frames++;
+        hud.frame();
+        hud.update(_lcd);
+        deadline += period;
+    }
+    _lcd.waitDMA();
+    _lcd.endWrite();
+
+    uint32_t intervals = frameStats.frames - 1;
+    if (intervals > 0)
+    {
+        double mean = (double)sumUs / intervals;
+        frameStats.meanUs = mean;
+        frameStats.jitterUs = sqrt(fmax(0.0, (double)sumSquares / intervals - mean * mean));
+        frameStats.fps = 1e6 / mean;
+    }
+    frameStats.renderUs = renderUs / frameStats.frames;
+    band0.deleteSprite();
+    band1.deleteSprite();
+}
+
+
+void FramePipeline::print(const char *name)
+{
+    const FrameStats &s = frameStats;
+    Serial.printf("%s: %u frames, %.1f fps (target %d), period %.1f ms, jitter %.2f ms, render %.1f ms, %u dropped\n",
+                  name, s.frames, s.fps, targetFps, s.meanUs / 1000.0, s.jitterUs / 1000.0, 
+                  s.renderUs / 1000.0, s.dropped);
+}
@@ -0,0 +1,62 @@
+/**
+ * Frame pipeline for animations
+ * 
+ * An animation is a sequence of frames, each drawn completely by a 
+ * render function. A 16 bit frame buffer of the whole screen doesn't 
+ * fit into memory, so every frame is rendered in bands of 40 rows into 
+ * two band sprites: while one band is sent to the lcd with DMA the next
+ * one is rendered into the other sprite. The first band of frame N+1 
+ * is rendered while the last band of frame N is still on its way.
+ * 
+ * The frames are paced to the target rate (FramePipeline::targetFps). 
+ * When a frame starts a whole period or more too late, the frames 
+ * whose time has passed are dropped, so the animation keeps its speed.
+ * The last frame is always shown.
+ * 
+ * The render function gets the band as canvas and the first row y0 of
+ * the band, all y coordinates have to be shifted by -y0. Primitives 
+ * outside of the band are clipped by the sprite.
+ * 
+ * Usage    void render(LovyanGFX &canvas, int y0, int frame, void *ctx)
+ *          {
+ *              canvas.drawRect(frame, frame - y0, 20, 20, TFT_RED);
+ *          }
+ *          FramePipeline fp(lcd);
+ *          fp.run(100, render, nullptr);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+
+struct FrameStats
+{
+    uint32_t frames;      // frames shown
+    uint32_t dropped;     // frames skipped because they were too late
+    uint32_t targetUs;    // frame period of the target rate
+    uint32_t meanUs;      // mean time between the start of two frames
+    uint32_t jitterUs;    // standard deviation of that time
+    uint32_t renderUs;    // mean time to render and send a frame
+    float    fps;         // achieved frame rate
+};
+
+extern FrameStats frameStats;   // of the last animation
+
+class FramePipeline
+{
+    public:
+        using Render = void(*)(LovyanGFX &canvas, int y0, int frame, void *ctx);
+        static constexpr int BAND_ROWS = 40;
+        static int targetFps;
+
+        FramePipeline(LGFX &lcd) : _lcd(lcd) {}
+
+        void run(int frames, Render render, void *ctx, uint16_t background = TFT_BLACK);
+        static void print(const char *name);
+
+    private:
+        void waitUntil(uint32_t us);
+
+        LGFX &_lcd;
+};
@@ -0,0 +1,152 @@
+#include "AALines.h"
+#include "Scanline.h"
+#include "Arena.h"
+#include <algorithm>
+
+bool AALines::enabled = false;
+
+AALines::AALines(LGFX &lcd, uint16_t pen, uint16_t background) : 
+    _lcd(lcd), _pen(pen), _background(background)
+{
+    for (int i = 0; i < LEVELS; i++)
+        _lut[i] = Scanline::swap(Scanline::lerp565(background, pen, i * 65536 / (LEVELS - 1)));
+}
+
+
+/**
+ * Draw the polyline translated by (tx, ty). The polyline must stay 
+ * valid as long as this AALines is used, e.g. from the geometry cache.
+ * Returns false when it could not be drawn anti-aliased.
+*/
+bool AALines::draw(const Polyline &p, int tx, int ty)
+{
+    if (_count == MAX_POLYLINES || p.count() == 0) return false;
+
+    Item &item = _item[_count];
+    item = { &p, (int16_t)tx, (int16_t)ty, INT16_MAX, INT16_MAX, INT16_MIN, INT16_MIN };
+    for (int i = 0; i < p.count(); i++)
+    {
+        const Vertex &v = p.vertices()[i];
+        if (Polyline::isBreak(v)) continue;
+        item.x0 = std::min<int>(item.x0, v.x + tx - 1);
+        item.y0 = std::min<int>(item.y0, v.y + ty - 1);
+        item.x1 = std::max<int>(item.x1, v.x + tx + 1);
+        item.y1 = std::max<int>(item.y1, v.y + ty + 1);
+    }
+    _count++;
+
+    const int x0 = std::max<int>(item.x0, 0), x1 = std::min<int>(item.x1, _lcd.width() - 1);
+    const int y0 = std::max<int>(item.y0, 0), y1 = std::min<int>(item.y1, _lcd.height() - 1);
+    if (x0 > x1 || y0 > y1) return true;
+
+    ArenaScope scope(frameArena);
+    const size_t bytes = _lcd.width() * BAND_ROWS;
+    uint8_t *coverage = frameArena.alloc<uint8_t>(bytes);
+    bool isHeap = coverage == nullptr;
+    if (isHeap) coverage = (uint8_t*)malloc(bytes);
+    if (coverage == nullptr)
+    {
+        log_e("No memory for the coverage band");
+        _count--;
+        return false;
+    }
+
+    Scanline sl(_lcd);
+    sl.begin();
+    for (int y = y0; y <= y1; y += BAND_ROWS)
+    {
+        Band b = { coverage, x0, y, x1 - x0 + 1, y1 - y + 1 < BAND_ROWS ? y1 - y + 1 : BAND_ROWS };
+        memset(b.coverage, 0, b.w * b.h);
+        for (int i = 0; i < _count; i++)
+        {
+            const Item &it = _item[i];
+            if (it.x1 >= b.x && it.x0 < b.x + b.w && it.y1 >= b.y && it.y0 < b.y + b.h) rasterize(it, b);
+        }
+        // only the runs of covered pixels are sent, the rest of the screen stays
+        for (int row = 0; row < b.h; row++)
+        {
+            const uint8_t *c = b.coverage + row * b.w;
+            for (int i = 0; i < b.w; )
+            {
+                if (c[i] < 8) { i++; continue; }
+                uint16_t *line = sl.line();
+                int start = i;
+                for (; i < b.w && c[i] >= 8; i++) *line++ = _lut[c[i] >> 3];
+                sl.flush(b.x + start, b.y + row, i - start);
+            }
+        }
+    }
+    sl.end();
+    if (isHeap) free(coverage);
+    return true;
+}
+
+
+void AALines::rasterize(const Item &item, Band &b)
+{
+    const Vertex *v = item.polyline->vertices();
+    for (int i = 1; i < item.polyline->count(); i++)
+    {
+        if (Polyline::isBreak(v[i - 1]) || Polyline::isBreak(v[i])) continue;
+        int x0 = v[i - 1].x + item.tx, y0 = v[i - 1].y + item.ty;
+        int x1 = v[i].x + item.tx,     y1 = v[i].y + item.ty;
+        if (std::max(x0, x1) < b.x - 1 || std::min(x0, x1) > b.x + b.w || 
+            std::max(y0, y1) < b.y - 1 || std::min(y0, y1) > b.y + b.h) continue;
+        wuLine(b, x0, y0, x1, y1);
+    }
+}
+
+
+inline void AALines::plot(Band &b, int x, int y, uint8_t c)
+{
+    x -= b.x;
+    y -= b.y;
+    if ((unsigned)x >= (unsigned)b.w || (unsigned)y >= (unsigned)b.h) return;
+    uint8_t &p = b.coverage[y * b.w + x];
+    if (c > p) p = c;
+}
+
+
+/**
+ * Wu's line between integer end points in Q16. Along the major axis 
+ * only the steps whose minor coordinate can fall into the band are 
+ * visited.
+*/
+void AALines::wuLine(Band &b, int x0, int y0, int x1, int y1)
+{
+    const bool steep = abs(y1 - y0) > abs(x1 - x0);
+    if (steep) { std::swap(x0, y0); std::swap(x1, y1); }
+    if (x0 > x1) { std::swap(x0, x1); std::swap(y0, y1); }
+
+    const int dx = x1 - x0;
+    const int32_t gradient = dx ? ((int32_t)(y1 - y0) << 16) / dx : 0;
+    int from = x0, to = x1;
+    if (steep)
+    {
+        // the major axis runs along the rows of the band
+        from = std::max(from, b.y - 1);
+        to   = std::min(to, b.y + b.h);
+    }
+    else
+    {
+        from = std::max(from, b.x - 1);
+        to   = std::min(to, b.x + b.w);
+    }
+    int32_t yq = ((int32_t)y0 << 16) + (int32_t)((int64_t)(from - x0) * gradient);
+    for (int x = from; x <= to; x++, yq += gradient)
+    {
+        int y = yq >> 16;
+        uint8_t f = (yq >> 8) & 0xFF;
+        if (steep)
+        {
+            plot(b, y, x, 255 - f);
+            plot(b, y + 1, x, f);
+        }
+        else
+        {
+            if (y + 1 < b.y || y > b.y + b.h) continue;
+            plot(b, x, y, 255 - f);
+            plot(b, x, y + 1, f);
+        }
+    }
+}
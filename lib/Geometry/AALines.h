@@ -0,0 +1,65 @@
+/**
+ * Anti-aliased polylines
+ * 
+ * Lines are drawn with Xiaolin Wu's algorithm in 8 bit fixed point: 
+ * each step along the major axis covers the two pixels next to the 
+ * exact line, weighted by their distance. The coverage goes into an 
+ * off-screen band of 32 rows, overlapping lines keep the larger 
+ * coverage. The band lives in the frame arena while draw() runs. 
+ * Each run of covered pixels in a row is colored through a blend LUT 
+ * for the pen and background color pair and pushed with DMA by 
+ * Scanline. So no pixel has to be read back from the panel.
+ * 
+ * Pixels without coverage are not sent, whatever was drawn there 
+ * stays. Polylines drawn before by the same AALines that reach into 
+ * the bounding box of the new one are rasterized again from their 
+ * cached vertices, so where they cross the larger coverage wins. 
+ * Covered pixels are blended against the background color, not 
+ * against other content below them.
+ * 
+ * The mode is switched on and off with the serial command "aa".
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "Polyline.h"
+
+class AALines
+{
+    public:
+        static constexpr int BAND_ROWS = 32;
+        static constexpr int MAX_POLYLINES = 16;
+        static constexpr int LEVELS = 32;       // coverage levels of the blend LUT, coverage >> 3
+        static bool enabled;
+
+        AALines(LGFX &lcd, uint16_t pen, uint16_t background);
+
+        bool draw(const Polyline &p, int tx, int ty);
+        uint16_t pen() const { return _pen; }
+        uint16_t background() const { return _background; }
+
+    private:
+        struct Item
+        {
+            const Polyline *polyline;
+            int16_t tx, ty;
+            int16_t x0, y0, x1, y1;   // bounding box on the lcd
+        };
+        struct Band
+        {
+            uint8_t *coverage;
+            int x, y, w, h;
+        };
+
+        void rasterize(const Item &item, Band &b);
+        void wuLine(Band &b, int x0, int y0, int x1, int y1);
+        static void plot(Band &b, int x, int y, uint8_t c);
+
+        LGFX    &_lcd;
+        uint16_t _pen, _background;
+        uint16_t _lut[LEVELS];          // byte swapped
+        Item     _item[MAX_POLYLINES];
+        int      _count = 0;
+};
@@ -0,0 +1,58 @@
+#include "GeometryCache.h"
+#include <new>
+
+GeometryCache geometryCache;
+
+/**
+ * The polyline of the curve, expanded on the first call. 
+ * The turtle is used for the recording and left unchanged. 
+ * Returns nullptr when the cache is full or out of memory.
+*/
+const Polyline *GeometryCache::get(Turtle &t, Curve curve, int order, float step)
+{
+    for (int i = 0; i < _count; i++)
+    {
+        const Entry &e = _entry[i];
+        if (e.curve == curve && e.order == order && e.step == step && e.heading == t.heading())
+            return e.polyline;
+    }
+
+    if (_count == MAX_ENTRIES) return nullptr;
+    Polyline *p = new (std::nothrow) Polyline();
+    if (p == nullptr) return nullptr;
+
+    int x = t.x(), y = t.y();
+    float heading = t.heading();
+    t.home(0, 0, heading);
+    t.record(p);
+    curve(t, order, step);
+    t.record(nullptr);
+    t.home(x, y, heading);
+
+    if (p->count() == 0)
+    {
+        delete p;
+        return nullptr;
+    }
+    if (! p->pack(persistentArena)) p->shrink();
+    _entry[_count++] = { curve, order, step, heading, p };
+    return p;
+}
+
+
+/**
+ * Vertices packed into the persistent arena stay reserved
+*/
+void GeometryCache::clear()
+{
+    for (int i = 0; i < _count; i++) delete _entry[i].polyline;
+    _count = 0;
+}
+
+
+size_t GeometryCache::bytes() const
+{
+    size_t n = 0;
+    for (int i = 0; i < _count; i++) n += _entry[i].polyline->bytes();
+    return n;
+}
@@ -0,0 +1,49 @@
+/**
+ * Geometry cache for turtle curves
+ * 
+ * A curve like the Koch curve or the dragon curve of a given order, 
+ * step and start heading is always the same sequence of lines. The cache expands it once 
+ * with a recording turtle into a polyline starting at (0, 0), later 
+ * calls get the polyline and draw it translated to the turtle position.
+ * 
+ * The turtle rounds every step to whole pixels, the recorded vertices
+ * are therefore exactly the points the turtle would draw, shifted by 
+ * its start position.
+ * 
+ * The finished polylines are packed into the persistent arena, they 
+ * stay on the heap only when the arena is full.
+ * 
+ * Usage    const Polyline *p = geometryCache.get(t, koch, 4, 200);
+ *          if (p) drawPolyline(lcd, *p, Affine::translate(x, y), TFT_WHITE);
+*/
+
+#pragma once
+#include "Polyline.h"
+#include "Turtle.h"
+
+class GeometryCache
+{
+    public:
+        using Curve = void(*)(Turtle &t, int order, float step);
+        static constexpr int MAX_ENTRIES = 32;
+
+        ~GeometryCache() { clear(); }
+        const Polyline *get(Turtle &t, Curve curve, int order, float step);
+        void   clear();
+        int    entries() const { return _count; }
+        size_t bytes() const;
+
+    private:
+        struct Entry
+        {
+            Curve     curve;
+            int       order;
+            float     step;
+            float     heading;
+            Polyline *polyline;
+        };
+        Entry _entry[MAX_ENTRIES];
+        int   _count = 0;
+};
+
+extern GeometryCache geometryCache;
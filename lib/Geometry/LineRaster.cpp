@@ -0,0 +1,105 @@
+#include "LineRaster.h"
+
+/**
+ * The visible steps k of a line whose coordinate along an axis is 
+ * p0 + s * k, for a viewport of lim pixels along that axis
+*/
+static void axisRange(int p0, int s, int lim, int64_t &lo, int64_t &hi)
+{
+    if (s > 0) { lo = -(int64_t)p0;            hi = (int64_t)lim - 1 - p0; }
+    else       { lo = (int64_t)p0 - (lim - 1); hi = p0; }
+}
+
+
+/**
+ * Draw the pixels of the line (x0, y0) - (x1, y1) that lie in the 
+ * viewport 0 <= x < w, 0 <= y < h.
+ *
+ * This Bresenham sets pixel k = 0 .. D of the line at the offsets k 
+ * along the major axis and m(k) = (2 d k + D - 1) / (2 D) along the 
+ * minor one (D, d the lengths along the axes), the pixels of the 
+ * error term loop of Turtle::bresenham. With m(k) in closed form the 
+ * line is clipped by its steps: the first and last visible k follow 
+ * from the viewport and the error term is known at the clip boundary, 
+ * so the clipped line has exactly the pixels of the whole one. Each 
+ * run of pixels with the same m goes out as one fast line.
+*/
+void writeLine(LGFX &lcd, int x0, int y0, int x1, int y1, int w, int h, uint16_t color)
+{
+    const bool isFlat = abs(x1 - x0) >= abs(y1 - y0);
+    const int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    const int64_t D = isFlat ? abs(x1 - x0) : abs(y1 - y0);
+    const int64_t d = isFlat ? abs(y1 - y0) : abs(x1 - x0);
+
+    // visible steps along the major axis, and offsets along the minor one
+    int64_t kLo, kHi, mLo, mHi;
+    if (isFlat) { axisRange(x0, sx, w, kLo, kHi); axisRange(y0, sy, h, mLo, mHi); }
+    else        { axisRange(y0, sy, h, kLo, kHi); axisRange(x0, sx, w, mLo, mHi); }
+    kLo = std::max<int64_t>(kLo, 0);
+    kHi = std::min<int64_t>(kHi, D);
+    mLo = std::max<int64_t>(mLo, 0);
+    mHi = std::min<int64_t>(mHi, d);
+    if (mLo > mHi) return;
+    if (d > 0)
+    {
+        // the first k with m(k) >= mLo, the last k with m(k) <= mHi
+        if (mLo > 0) kLo = std::max<int64_t>(kLo, (2 * D * mLo - D + 1 + 2 * d - 1) / (2 * d));
+        kHi = std::min<int64_t>(kHi, (2 * D * mHi + D) / (2 * d));
+    }
+    if (kLo > kHi) return;
+
+    int64_t m = D > 0 ? (2 * d * kLo + D - 1) / (2 * D) : 0;
+    for (int64_t k = kLo; k <= kHi; m++)
+    {
+        int64_t end = d > 0 ? std::min<int64_t>(kHi, (2 * D * m + D) / (2 * d)) : kHi;
+        int len = end - k + 1;
+        if (isFlat) lcd.writeFastHLine(sx > 0 ? x0 + k : x0 - end, y0 + sy * m, len, color);
+        else        lcd.writeFastVLine(x0 + sx * m, sy > 0 ? y0 + k : y0 - end, len, color);
+        k = end + 1;
+    }
+}
+
+
+/**
+ * The columns xa .. xb of the pixels that writeLine() sets in row y,
+ * false when it sets none. A flat line has a run of pixels with the 
+ * same m in the row, a steep one a single pixel.
+*/
+bool lineRow(int x0, int y0, int x1, int y1, int y, int &xa, int &xb)
+{
+    const bool isFlat = abs(x1 - x0) >= abs(y1 - y0);
+    const int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    const int64_t D = isFlat ? abs(x1 - x0) : abs(y1 - y0);
+    const int64_t d = isFlat ? abs(y1 - y0) : abs(x1 - x0);
+
+    if (isFlat)
+    {
+        // the steps k with m(k) == m
+        const int64_t m = sy * (y - y0);
+        if (m < 0 || m > d) return false;
+        int64_t kLo = 0, kHi = D;
+        if (d > 0)
+        {
+            if (m > 0) kLo = (2 * D * m - D + 1 + 2 * d - 1) / (2 * d);
+            kHi = std::min<int64_t>(D, (2 * D * m + D) / (2 * d));
+        }
+        if (kLo > kHi) return false;
+        xa = sx > 0 ? x0 + kLo : x0 - kHi;
+        xb = sx > 0 ? x0 + kHi : x0 - kLo;
+    }
+    else
+    {
+        const int64_t k = sy * (y - y0);
+        if (k < 0 || k > D) return false;
+        xa = xb = x0 + sx * (int)((2 * d * k + D - 1) / (2 * D));
+    }
+    return true;
+}
+
+
+void drawClippedLine(LGFX &lcd, int x0, int y0, int x1, int y1, uint16_t color)
+{
+    lcd.startWrite();
+    writeLine(lcd, x0, y0, x1, y1, lcd.width(), lcd.height(), color);
+    lcd.endWrite();
+}
@@ -0,0 +1,23 @@
+/**
+ * Clipped integer lines
+ * 
+ * writeLine() rasterizes with Bresenham, clipped to the viewport by 
+ * its steps: lines completely outside cost a few divisions, and the 
+ * visible part has exactly the pixels of the unclipped line. Each run 
+ * of pixels in the same row (flat lines) or column (steep lines) goes 
+ * out as one fast line, so a window is set per run instead of per 
+ * pixel. writeLine() must be called inside startWrite() / endWrite(), 
+ * all lines of a polyline then go out in one transaction.
+ * 
+ * lineRow() gives the columns of the pixels writeLine() sets in one 
+ * row, for renderers that build the screen row by row.
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+
+void writeLine(LGFX &lcd, int x0, int y0, int x1, int y1, int w, int h, uint16_t color);
+void drawClippedLine(LGFX &lcd, int x0, int y0, int x1, int y1, uint16_t color);
+bool lineRow(int x0, int y0, int x1, int y1, int y, int &xa, int &xb);
@@ -0,0 +1,176 @@
+#include "Polyline.h"
+#include "LineRaster.h"
+#include <esp_heap_caps.h>
+
+Polyline::~Polyline()
+{
+    if (! _packed) heap_caps_free(_v);
+}
+
+
+/**
+ * Grow the vertex array, preferably in PSRAM
+*/
+bool Polyline::reserve(int capacity)
+{
+    if (capacity <= _capacity) return true;
+    if (_packed) return false;
+    size_t size = capacity * sizeof(Vertex);
+    Vertex *v = (Vertex*)heap_caps_realloc(_v, size, MALLOC_CAP_SPIRAM);
+    if (v == nullptr) v = (Vertex*)heap_caps_realloc(_v, size, MALLOC_CAP_8BIT);
+    if (v == nullptr)
+    {
+        log_e("No memory for %d vertices", capacity);
+        return false;
+    }
+    _v = v;
+    _capacity = capacity;
+    return true;
+}
+
+
+bool Polyline::add(int x, int y)
+{
+    if (_count == _capacity && ! reserve(_capacity ? 2 * _capacity : 64)) return false;
+    _v[_count].x = x;
+    _v[_count].y = y;
+    _count++;
+    return true;
+}
+
+
+/**
+ * Start a new line at (x, y)
+*/
+bool Polyline::moveTo(int x, int y)
+{
+    if (_count > 0 && ! add(BREAK, BREAK)) return false;
+    return add(x, y);
+}
+
+
+/**
+ * Release the unused capacity once the polyline is complete
+*/
+void Polyline::shrink()
+{
+    if (_count == 0 || _count == _capacity || _packed) return;
+    Vertex *v = (Vertex*)heap_caps_realloc(_v, _count * sizeof(Vertex), MALLOC_CAP_SPIRAM);
+    if (v == nullptr) v = (Vertex*)heap_caps_realloc(_v, _count * sizeof(Vertex), MALLOC_CAP_8BIT);
+    if (v == nullptr) return;
+    _v = v;
+    _capacity = _count;
+}
+
+
+/**
+ * Move the vertices into the arena and free the heap copy
+*/
+bool Polyline::pack(Arena &arena)
+{
+    if (_packed || _count == 0) return _packed;
+    Vertex *v = arena.alloc<Vertex>(_count);
+    if (v == nullptr) return false;
+    memcpy(v, _v, _count * sizeof(Vertex));
+    heap_caps_free(_v);
+    _v = v;
+    _capacity = _count;
+    _packed = true;
+    return true;
+}
+
+
+/**
+ * Smallest rectangle (x0, y0) .. (x1, y1) holding all vertices
+*/
+void Polyline::bounds(int &x0, int &y0, int &x1, int &y1) const
+{
+    x0 = y0 = INT16_MAX;
+    x1 = y1 = INT16_MIN;
+    for (int i = 0; i < _count; i++)
+    {
+        if (isBreak(_v[i])) continue;
+        x0 = std::min<int>(x0, _v[i].x);  x1 = std::max<int>(x1, _v[i].x);
+        y0 = std::min<int>(y0, _v[i].y);  y1 = std::max<int>(y1, _v[i].y);
+    }
+}
+
+
+Affine Affine::rotate(float degrees)
+{
+    Affine m;
+    float r = degrees * (float)(PI / 180.0);
+    m.a = cosf(r); m.b = -sinf(r);
+    m.c = sinf(r); m.d =  cosf(r);
+    return m;
+}
+
+
+Affine Affine::operator*(const Affine &m) const
+{
+    Affine r;
+    r.a  = a * m.a  + b * m.c;
+    r.b  = a * m.b  + b * m.d;
+    r.c  = c * m.a  + d * m.c;
+    r.d  = c * m.b  + d * m.d;
+    r.tx = a * m.tx + b * m.ty + tx;
+    r.ty = c * m.tx + d * m.ty + ty;
+    return r;
+}
+
+
+/**
+ * Draw all lines of the polyline in one transaction, clipped to the 
+ * lcd. A pure integer translation is added to the vertices without 
+ * rounding.
+*/
+void drawPolyline(LGFX &lcd, const Polyline &p, const Affine &m, uint16_t color)
+{
+    const Vertex *v = p.vertices();
+    const bool isTranslation = m.isTranslation();
+    const int tx = m.tx, ty = m.ty;
+    const int w = lcd.width(), h = lcd.height();
+    bool hasStart = false;
+    int x0 = 0, y0 = 0;
+
+    lcd.startWrite();
+    for (int i = 0; i < p.count(); i++)
+    {
+        if (Polyline::isBreak(v[i]))
+        {
+            hasStart = false;
+            continue;
+        }
+        int x1, y1;
+        if (isTranslation) { x1 = v[i].x + tx; y1 = v[i].y + ty; }
+        else m.apply(v[i].x, v[i].y, x1, y1);
+        if (hasStart) writeLine(lcd, x0, y0, x1, y1, w, h, color);
+        x0 = x1;
+        y0 = y1;
+        hasStart = true;
+    }
+    lcd.endWrite();
+}
+
+
+/**
+ * Set the pixels of row y of the polyline, translated by (tx, ty), in 
+ * line, which holds the pixels 0 .. width-1 of the row. Each line sets 
+ * the pixels writeLine() sets in that row, so the rows match the 
+ * polyline drawn with drawPolyline().
+*/
+void polylineRow(const Polyline &p, int tx, int ty, int y, uint16_t *line, int width, uint16_t color)
+{
+    const Vertex *v = p.vertices();
+    y -= ty;
+    for (int i = 1; i < p.count(); i++)
+    {
+        const Vertex &a = v[i - 1], &b = v[i];
+        if (Polyline::isBreak(a) || Polyline::isBreak(b)) continue;
+        int xa, xb;
+        if (! lineRow(a.x, a.y, b.x, b.y, y, xa, xb)) continue;
+        xa = std::max(xa + tx, 0);
+        xb = std::min(xb + tx, width - 1);
+        for (int x = xa; x <= xb; x++) line[x] = color;
+    }
+}
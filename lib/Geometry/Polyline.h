@@ -0,0 +1,85 @@
+/**
+ * Polylines of int16 vertices
+ * 
+ * A polyline is a sequence of connected points. A vertex with both 
+ * coordinates BREAK ends the current line, the next vertex starts a 
+ * new one, so one polyline can hold several separate curves.
+ * 
+ * The vertices are allocated from PSRAM when the board has it, 
+ * else from the internal heap. 4 bytes per vertex. A complete polyline 
+ * can be packed into an arena, it can't grow any more afterwards.
+ * 
+ * An Affine transform maps the vertices when they are drawn, so one 
+ * polyline can be drawn at different positions, sizes and angles. 
+ * drawPolyline() clips the lines to the lcd and sends them in one 
+ * transaction (see LineRaster.h). polylineRow() sets the pixels of 
+ * the same lines in one row of a line buffer instead, for content 
+ * that is rendered row by row like the scrolling gallery.
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "Arena.h"
+
+struct Vertex
+{
+    int16_t x, y;
+};
+
+class Polyline
+{
+    public:
+        static constexpr int16_t BREAK = INT16_MIN;
+
+        Polyline() {}
+        ~Polyline();
+        Polyline(const Polyline&) = delete;
+        Polyline &operator=(const Polyline&) = delete;
+
+        bool add(int x, int y);
+        bool moveTo(int x, int y);
+        void shrink();
+        bool pack(Arena &arena);
+        void clear() { _count = 0; }
+        void bounds(int &x0, int &y0, int &x1, int &y1) const;
+
+        int           count() const { return _count; }
+        const Vertex *vertices() const { return _v; }
+        size_t        bytes() const { return _capacity * sizeof(Vertex); }
+        static bool   isBreak(const Vertex &v) { return v.x == BREAK && v.y == BREAK; }
+
+    private:
+        bool reserve(int capacity);
+
+        Vertex *_v = nullptr;
+        int _count = 0;
+        int _capacity = 0;
+        bool _packed = false;         // the vertices belong to an arena
+};
+
+
+/**
+ * x' = a*x + b*y + tx,  y' = c*x + d*y + ty
+*/
+struct Affine
+{
+    float a = 1, b = 0, c = 0, d = 1, tx = 0, ty = 0;
+
+    static Affine translate(float tx, float ty) { Affine m; m.tx = tx; m.ty = ty; return m; }
+    static Affine scale(float sx, float sy) { Affine m; m.a = sx; m.d = sy; return m; }
+    static Affine rotate(float degrees);
+
+    Affine operator*(const Affine &m) const;  // apply m first, then this
+    bool isTranslation() const { return a == 1 && b == 0 && c == 0 && d == 1 && tx == (int)tx && ty == (int)ty; }
+    void apply(int x, int y, int &ox, int &oy) const
+    {
+        ox = lroundf(a * x + b * y + tx);
+        oy = lroundf(c * x + d * y + ty);
+    }
+};
+
+
+void drawPolyline(LGFX &lcd, const Polyline &p, const Affine &m, uint16_t color);
+void polylineRow(const Polyline &p, int tx, int ty, int y, uint16_t *line, int width, uint16_t color);
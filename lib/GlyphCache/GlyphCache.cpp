@@ -0,0 +1,223 @@
+#include "GlyphCache.h"
+#include "Arena.h"
+#include "RenderStats.h"
+
+GlyphCache glyphCache;
+GlyphCache smallGlyphCache;
+
+
+/**
+ * Use font, the glyphs cached so far are dropped unless it is the 
+ * font in use. The pool grows to the rows of all glyphs of the font, 
+ * up to POOL_ROWS.
+*/
+void GlyphCache::setFont(const lgfx::GFXfont *font)
+{
+    if (font == _font) return;
+    _font = font;
+    _used = 0;
+    _ascent = _descent = 0;
+    int rows = 0;
+    int n = font->last - font->first + 1;
+    for (int i = 0; i < n; i++)
+    {
+        const lgfx::GFXglyph &g = font->glyph[i];
+        if (-g.yOffset > _ascent) _ascent = -g.yOffset;
+        if (g.yOffset + g.height > _descent) _descent = g.yOffset + g.height;
+        if (i >= MAX_CHARS) continue;
+        _glyph[i].row = -1;
+        if (g.width <= 32 && g.height <= MAX_GLYPH_HEIGHT) rows += g.height;
+    }
+    rows = std::min(rows, POOL_ROWS);
+    if (rows <= _capacity) return;
+    // the pool of a smaller font stays in the arena, fonts rarely change
+    uint32_t *pool = persistentArena.alloc<uint32_t>(rows);
+    if (pool == nullptr) pool = (uint32_t*)malloc(rows * sizeof(uint32_t));
+    if (pool == nullptr)
+    {
+        log_e("No memory for the glyphs, they are decoded on each use");
+        return;
+    }
+    if (_rows && ! persistentArena.contains(_rows)) free(_rows);
+    _rows = pool;
+    _capacity = rows;
+}
+
+
+/**
+ * The glyph of c and its rows, decoded on the first use. 
+ * Returns nullptr for characters the cache can't draw.
+*/
+const GlyphCache::Glyph *GlyphCache::glyph(char c, const uint32_t *&rows)
+{
+    if (_font == nullptr) return nullptr;
+    int i = (uint8_t)c - _font->first;
+    if (i < 0 || i > _font->last - _font->first || i >= MAX_CHARS) return nullptr;
+    Glyph &g = _glyph[i];
+    if (g.row >= 0)
+    {
+        rows = &_rows[g.row];
+        return &g;
+    }
+
+    const lgfx::GFXglyph &fg = _font->glyph[i];
+    if (fg.width > 32 || fg.height > MAX_GLYPH_HEIGHT) return nullptr;
+    g.w = fg.width;
+    g.h = fg.height;
+    g.xAdvance = fg.xAdvance;
+    g.xOffset = fg.xOffset;
+    g.yOffset = fg.yOffset;
+
+    uint32_t *dst = _scratch;
+    bool keep = _used + g.h <= _capacity;
+    if (keep) dst = &_rows[_used];
+    const uint8_t *bits = _font->bitmap + fg.bitmapOffset;
+    uint32_t bit = 0;
+    for (int y = 0; y < g.h; y++)
+    {
+        uint32_t row = 0;
+        for (int x = 0; x < g.w; x++, bit++)
+            if (bits[bit >> 3] & (0x80 >> (bit & 7))) row |= 1u << x;
+        dst[y] = row;
+    }
+    if (keep)
+    {
+        g.row = _used;
+        _used += g.h;
+    }
+    rows = dst;
+    return &g;
+}
+
+
+int GlyphCache::textWidth(const char *s)
+{
+    int w = 0, right = 0;
+    const uint32_t *rows;
+    for (; *s; s++)
+    {
+        const Glyph *g = glyph(*s, rows);
+        if (g == nullptr) continue;
+        if (w + g->xOffset + g->w > right) right = w + g->xOffset + g->w;
+        w += g->xAdvance;
+    }
+    return w > right ? w : right;
+}
+
+
+/**
+ * Draw s on the background bg, the whole text box is sent in one 
+ * address window. Parts outside of dst are clipped.
+*/
+void GlyphCache::drawText(LovyanGFX &dst, const char *s, int x, int y, uint16_t fg, uint16_t bg)
+{
+    const int w = textWidth(s);
+    const int h = height();
+    if (w == 0 || h == 0) return;
+
+    ArenaScope scope(frameArena);
+    uint16_t *box = frameArena.alloc<uint16_t>(w * h);
+    if (box == nullptr)
+    {
+        dst.fillRect(x, y, w, h, bg);
+        drawText(dst, s, x, y, fg);
+        return;
+    }
+    const uint16_t fore = (fg << 8) | (fg >> 8);      // byte swapped like the panel
+    const uint16_t back = (bg << 8) | (bg >> 8);
+    for (int i = 0; i < w * h; i++) box[i] = back;
+
+    int pen = 0;
+    const uint32_t *rows;
+    for (; *s; s++)
+    {
+        const Glyph *g = glyph(*s, rows);
+        if (g == nullptr) continue;
+        const int left = pen + g->xOffset;
+        for (int r = 0; r < g->h; r++)
+        {
+            uint16_t *p = box + (_ascent + g->yOffset + r) * w;
+            for (uint32_t bits = rows[r]; bits; bits &= bits - 1)
+            {
+                int col = left + __builtin_ctz(bits);
+                if (col >= 0 && col < w) p[col] = fore;
+            }
+        }
+        pen += g->xAdvance;
+    }
+
+    dst.startWrite();
+    if (x >= 0 && y >= 0 && x + w <= dst.width() && y + h <= dst.height())
+    {
+        dst.setWindow(x, y, x + w - 1, y + h - 1);
+        dst.writePixels((lgfx::swap565_t*)box, w * h);
+    }
+    else dst.pushImage(x, y, w, h, (lgfx::swap565_t*)box);
+    dst.endWrite();
+    renderCounters.add(2 * w * h);
+}
+
+
+/**
+ * Draw s without background, each row of set pixels of a glyph 
+ * becomes one horizontal line
+*/
+void GlyphCache::drawText(LovyanGFX &dst, const char *s, int x, int y, uint16_t fg)
+{
+    const uint32_t *rows;
+    dst.startWrite();
+    for (; *s; s++)
+    {
+        const Glyph *g = glyph(*s, rows);
+        if (g == nullptr) continue;
+        int x0 = x + g->xOffset;
+        int y0 = y + _ascent + g->yOffset;
+        for (int r = 0; r < g->h; r++)
+        {
+            uint32_t bits = rows[r];
+            while (bits)
+            {
+                int start = __builtin_ctz(bits);
+                uint32_t rest = ~(bits >> start);
+                int len = rest ? __builtin_ctz(rest) : 32 - start;
+                dst.writeFastHLine(x0 + start, y0 + r, len, fg);
+                bits &= len + start >= 32 ? 0 : ~0u << (start + len);
+            }
+        }
+        x += g->xAdvance;
+    }
+    dst.endWrite();
+}
+
+
+int GlyphCache::advance(char c)
+{
+    const uint32_t *rows;
+    const Glyph *g = glyph(c, rows);
+    return g ? g->xAdvance : 0;
+}
+
+
+/**
+ * Set the pixels of c with the top left corner of its text box at 
+ * (x, y) in mask, a bitmap of rows with stride 32 bit words each 
+ * (bit x & 31 of word x >> 5 is column x). Pixels outside are clipped.
+*/
+void GlyphCache::drawMask(char c, uint32_t *mask, int stride, int rows, int x, int y)
+{
+    const uint32_t *glyphRows;
+    const Glyph *g = glyph(c, glyphRows);
+    if (g == nullptr) return;
+    const int width = 32 * stride;
+    for (int r = 0; r < g->h; r++)
+    {
+        int my = y + _ascent + g->yOffset + r;
+        if (my < 0 || my >= rows) continue;
+        uint32_t *row = mask + my * stride;
+        for (uint32_t bits = glyphRows[r]; bits; bits &= bits - 1)
+        {
+            int mx = x + g->xOffset + __builtin_ctz(bits);
+            if (mx >= 0 && mx < width) row[mx >> 5] |= 1u << (mx & 31);
+        }
+    }
+}
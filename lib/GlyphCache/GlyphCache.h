@@ -0,0 +1,70 @@
+/**
+ * Glyph cache and text runs
+ * 
+ * The glyphs of a GFXfont are stored as a continuous stream of bits, 
+ * drawChar() decodes them again for every character it draws. The 
+ * cache decodes each glyph once, on its first use, into one 32 bit 
+ * word per row (bit x is the pixel in column x), so a row can be 
+ * scanned for set pixels with a few bit operations.
+ * 
+ * drawText() lays out a whole string. With a background color the 
+ * text box is rendered into a buffer of the frame arena and sent in 
+ * one address window; without, the set pixels are drawn as horizontal 
+ * runs in one transaction. The colors are applied while drawing, so 
+ * the same cached glyphs serve every color pair.
+ * 
+ * y is the top of the text box as with textdatum TL_DATUM, the box is 
+ * as high as the highest ascent plus the deepest descent of the font.
+ * 
+ * drawMask() sets the pixels of a glyph in a 1 bit mask instead, for 
+ * overlays that are combined with other pixels later.
+ * 
+ * The pool of decoded rows is sized for the font on the first 
+ * setFont() and taken from the persistent arena, so a small font 
+ * costs only what its glyphs need. Caches of the same font are shared, 
+ * smallGlyphCache holds DejaVu9 for the HUD and the run log.
+ * 
+ * Usage    glyphCache.setFont(&fonts::DejaVu18);
+ *          glyphCache.drawText(lcd, "12.5 fps", 10, 10, TFT_WHITE, TFT_BLACK);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+
+class GlyphCache
+{
+    public:
+        static constexpr int MAX_CHARS = 96;          // ' ' .. '~' of the usual fonts
+        static constexpr int MAX_GLYPH_HEIGHT = 48;
+        static constexpr int POOL_ROWS = 1024;        // at most, glyphs beyond are decoded on each use
+
+        void setFont(const lgfx::GFXfont *font);
+        int  textWidth(const char *s);
+        int  height() const { return _ascent + _descent; }
+        void drawText(LovyanGFX &dst, const char *s, int x, int y, uint16_t fg, uint16_t bg);
+        void drawText(LovyanGFX &dst, const char *s, int x, int y, uint16_t fg);
+        void drawMask(char c, uint32_t *mask, int stride, int rows, int x, int y);
+        int  advance(char c);
+
+    private:
+        struct Glyph
+        {
+            int16_t row;          // first row in the pool, -1 while not decoded
+            uint8_t w, h, xAdvance;
+            int8_t  xOffset, yOffset;
+        };
+
+        const Glyph *glyph(char c, const uint32_t *&rows);
+
+        const lgfx::GFXfont *_font = nullptr;
+        Glyph    _glyph[MAX_CHARS];
+        uint32_t *_rows = nullptr;             // in the persistent arena
+        uint32_t _scratch[MAX_GLYPH_HEIGHT];   // for glyphs that don't fit into the pool
+        int      _capacity = 0;                // rows of the pool
+        int      _used = 0;
+        int      _ascent = 0, _descent = 0;
+};
+
+extern GlyphCache glyphCache;       // of the display font
+extern GlyphCache smallGlyphCache;  // DejaVu9
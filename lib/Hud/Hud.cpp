@@ -0,0 +1,154 @@
+#include "Hud.h"
+#include "RenderStats.h"
+#include "Arena.h"
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+
+Hud hud;
+bool Hud::enabled = false;
+
+constexpr uint32_t LCD_SPI_CLOCK = 40000000;    // freq_write of the lcd configuration
+
+static inline uint16_t swap565(uint16_t c) { return (c << 8) | (c >> 8); }
+
+
+/**
+ * Size the cells for the widest character of the font
+*/
+void Hud::begin()
+{
+    _font.setFont(&fonts::DejaVu9);
+    for (const char *c = "0123456789. %/KBabefhimps"; *c; c++)
+        if (_font.advance(*c) > _cellW) _cellW = _font.advance(*c);
+    _lineH = _font.height();
+    _w = CHARS * _cellW;
+    _h = LINES * _lineH;
+    if (_w > MAX_WIDTH) _w = MAX_WIDTH;
+    if (_h > MAX_ROWS) _h = MAX_ROWS;
+    memset(_text, ' ', sizeof(_text));
+    for (int i = 0; i < LINES; i++) _text[i][CHARS] = '\0';
+    memset(_mask, 0, sizeof(_mask));
+    invalidate();
+    _lastMs = millis();
+    _ready = true;
+}
+
+
+/**
+ * Render the cells of line whose character changes
+*/
+void Hud::setLine(int line, const char *text)
+{
+    bool ended = false;
+    for (int i = 0; i < CHARS; i++)
+    {
+        char c = ended || text[i] == '\0' ? ' ' : text[i];
+        ended = ended || text[i] == '\0';
+        if (c == _text[line][i]) continue;
+        _text[line][i] = c;
+        _dirty[line] |= 1u << i;
+
+        int x0 = i * _cellW, y0 = line * _lineH;
+        for (int y = y0; y < y0 + _lineH && y < _h; y++)
+            for (int x = x0; x < x0 + _cellW && x < _w; x++) 
+                _mask[y * STRIDE + (x >> 5)] &= ~(1u << (x & 31));
+        _font.drawMask(c, _mask, STRIDE, _h, x0, y0);
+    }
+}
+
+
+/**
+ * Sample the values when UPDATE_MS have passed since the last sample
+*/
+void Hud::update(LovyanGFX &lcd)
+{
+    if (! enabled) return;
+    if (! _ready) begin();
+    _x = lcd.width() - _w - 2;
+    uint32_t now = millis();
+    uint32_t ms = now - _lastMs;
+    if (ms < UPDATE_MS) return;
+    const int64_t start = esp_timer_get_time();
+
+    uint32_t bytes = renderCounters.bytesFlushed;
+    if (bytes < _lastBytes) _lastBytes = 0;             // counters reset by a new activity
+    uint32_t bytesPerSecond = (uint64_t)(bytes - _lastBytes) * 1000 / ms;
+    float fps = _frames * 1000.0f / ms;
+    char s[CHARS + 8];
+    snprintf(s, sizeof(s), "%5.1f fps", fps);
+    setLine(0, s);
+    snprintf(s, sizeof(s), "%5.1f ms", fps > 0 ? 1000.0f / fps : 0.0f);
+    setLine(1, s);
+    snprintf(s, sizeof(s), "%5u KB/s", bytesPerSecond >> 10);
+    setLine(2, s);
+    snprintf(s, sizeof(s), "%5u KB", heap_caps_get_free_size(MALLOC_CAP_INTERNAL) >> 10);
+    setLine(3, s);
+    snprintf(s, sizeof(s), "%5u %% spi", (uint32_t)((uint64_t)bytesPerSecond * 8 * 100 / LCD_SPI_CLOCK));
+    setLine(4, s);
+
+    _lastMs = now;
+    _lastBytes = bytes;
+    _frames = 0;
+    _busyUs += esp_timer_get_time() - start;
+}
+
+
+/**
+ * Combine the HUD with the row y of the screen, line holds the 
+ * len byte swapped pixels starting at column x
+*/
+void Hud::overlayRow(uint16_t *line, int x, int y, int len)
+{
+    if (! enabled || ! _ready || y < _y || y >= _y + _h) return;
+    const int64_t start = esp_timer_get_time();
+    const uint32_t *row = _mask + (y - _y) * STRIDE;
+    const uint16_t fg = swap565(FOREGROUND), bg = swap565(BACKGROUND);
+    int from = _x > x ? _x : x;
+    int to = _x + _w < x + len ? _x + _w : x + len;
+    for (int sx = from; sx < to; sx++)
+    {
+        int mx = sx - _x;
+        line[sx - x] = row[mx >> 5] & (1u << (mx & 31)) ? fg : bg;
+    }
+    _busyUs += esp_timer_get_time() - start;
+}
+
+
+/**
+ * Combine the HUD with a band of rows starting at row y0 of the screen
+*/
+void Hud::overlay(uint16_t *pixels, int width, int y0, int rows)
+{
+    if (! enabled || ! _ready || y0 >= _y + _h || y0 + rows <= _y) return;
+    for (int r = 0; r < rows; r++) overlayRow(pixels + r * width, 0, y0 + r, width);
+}
+
+
+/**
+ * Send the changed cells to the lcd, cell by cell through a buffer 
+ * of one cell in the frame arena
+*/
+void Hud::draw(LovyanGFX &lcd)
+{
+    update(lcd);
+    if (! enabled || ! _ready) return;
+    ArenaScope scope(frameArena);
+    uint16_t *cell = frameArena.alloc<uint16_t>(_cellW * _lineH);
+    if (cell == nullptr) return;
+    lcd.startWrite();
+    for (int line = 0; line < LINES; line++)
+    {
+        for (int i = 0; _dirty[line] && i < CHARS; i++)
+        {
+            if (! (_dirty[line] & (1u << i))) continue;
+            _dirty[line] &= ~(1u << i);
+            int x0 = i * _cellW, y0 = line * _lineH;
+            for (int r = 0; r < _lineH; r++) 
+                overlayRow(cell + r * _cellW, _x + x0, _y + y0 + r, _cellW);
+            lcd.pushImage(_x + x0, _y + y0, _cellW, _lineH, (lgfx::swap565_t*)cell);
+            renderCounters.add(2 * _cellW * _lineH);
+        }
+    }
+    lcd.endWrite();
+}
+
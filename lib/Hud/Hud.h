@@ -0,0 +1,75 @@
+/**
+ * Performance HUD
+ * 
+ * Shows frame rate, frame time, bytes sent to the panel per second, 
+ * free heap and the use of the SPI bus of the lcd in the top right 
+ * corner of the screen, over any activity. The values are sampled at 
+ * a fixed rate of two per second.
+ * 
+ * The HUD is a 1 bit mask of a few lines of text in a small font, laid 
+ * out in cells of equal width. Only the cells whose character changed 
+ * are rendered again. The mask is combined with the pixels where they 
+ * are produced:
+ * 
+ *  - overlay() puts it into the band sprites of the FramePipeline
+ *  - overlayRow() into the rows of the Scanline buffers
+ *  - draw() sends the changed cells to the lcd through a buffer of one 
+ *    cell, used by the main loop between the activities
+ * 
+ * so the screen is never redrawn for the HUD. The work is a few hundred 
+ * bit tests per band or row that crosses the HUD, it is sampled once 
+ * per frame (Scanline::begin() or a FramePipeline frame). The time 
+ * spent for it is added up in busyUs(), the runner of the activities 
+ * prints its share of the render time.
+ * 
+ * The overlays replace the pixels below the HUD, so the main loop 
+ * takes no screenshots while it is on.
+ * 
+ * Usage    Hud::enabled = true;
+ *          hud.update(lcd);       // with every frame, samples when due
+ *          hud.overlayRow(line, 0, y, lcd.width());
+ *          hud.draw(lcd);         // directly to the lcd
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "GlyphCache.h"
+
+class Hud
+{
+    public:
+        static constexpr int LINES = 5;
+        static constexpr int CHARS = 10;
+        static constexpr int MAX_WIDTH = 128;         // pixels, 4 words per mask row
+        static constexpr int MAX_ROWS = 80;
+        static constexpr int STRIDE = MAX_WIDTH / 32;
+        static constexpr uint32_t UPDATE_MS = 500;
+        static constexpr uint16_t FOREGROUND = TFT_YELLOW;
+        static constexpr uint16_t BACKGROUND = TFT_BLACK;
+        static bool enabled;
+
+        void update(LovyanGFX &lcd);
+        void frame() { _frames++; }
+        void invalidate() { for (int i = 0; i < LINES; i++) _dirty[i] = (1u << CHARS) - 1; }
+        void overlay(uint16_t *pixels, int width, int y0, int rows);
+        void overlayRow(uint16_t *line, int x, int y, int len);
+        void draw(LovyanGFX &lcd);
+        int64_t busyUs() const { return _busyUs; }
+
+    private:
+        void begin();
+        void setLine(int line, const char *text);
+
+        GlyphCache &_font = smallGlyphCache;
+        bool     _ready = false;
+        int      _cellW = 0, _lineH = 0, _w = 0, _h = 0;
+        int      _x = 0, _y = 2;                      // top left corner on the screen
+        char     _text[LINES][CHARS + 1];
+        uint16_t _dirty[LINES];                       // cells not yet sent by draw()
+        uint32_t _mask[MAX_ROWS * STRIDE];
+        uint32_t _lastMs = 0, _frames = 0, _lastBytes = 0;
+        int64_t  _busyUs = 0;                         // spent in update() and the overlays
+};
+
+extern Hud hud;
@@ -0,0 +1,121 @@
+#include "MemTelemetry.h"
+
+MemTelemetry memTelemetry;
+
+
+/**
+ * Add a task whose stack high-water mark is sampled
+*/
+void MemTelemetry::watch(TaskHandle_t task, const char *name)
+{
+    if (task == nullptr) return;
+    for (int i = 0; i < _nbrTasks; i++) 
+        if (_task[i] == task) return;
+    if (_nbrTasks >= MAX_WATCHED_TASKS)
+    {
+        log_e("Can't watch %s, already %d tasks", name, MAX_WATCHED_TASKS);
+        return;
+    }
+    _task[_nbrTasks] = task;
+    _taskName[_nbrTasks] = name;
+    _nbrTasks++;
+}
+
+
+void MemTelemetry::sample(MemSample &s)
+{
+    s.internalFree    = heap_caps_get_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s.internalLargest = heap_caps_get_largest_free_block(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    s.dmaFree         = heap_caps_get_free_size(MALLOC_CAP_DMA);
+    s.dmaLargest      = heap_caps_get_largest_free_block(MALLOC_CAP_DMA);
+    s.psramFree       = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    s.psramLargest    = heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM);
+    for (int i = 0; i < _nbrTasks; i++) 
+        s.stackFree[i] = uxTaskGetStackHighWaterMark(_task[i]);
+}
+
+
+/**
+ * Fragmentation of the internal heap in %
+*/
+int MemTelemetry::fragmentation(const MemSample &s)
+{
+    if (s.internalFree == 0) return 0;
+    return 100 - (int)(100ull * s.internalLargest / s.internalFree);
+}
+
+
+void MemTelemetry::compareStacks(const MemSample &from, const MemSample &to, const char *when)
+{
+    for (int i = 0; i < _nbrTasks; i++)
+    {
+        if (to.stackFree[i] >= from.stackFree[i]) continue;
+        Serial.printf("mem  %-18s stack of %s %u bytes deeper, %u bytes left\n", 
+                      when, _taskName[i], from.stackFree[i] - to.stackFree[i], to.stackFree[i]);
+        if (to.stackFree[i] < STACK_RESERVE)
+            log_w("stack of %s nearly exhausted, %u bytes left", _taskName[i], to.stackFree[i]);
+    }
+}
+
+
+/**
+ * Take the sample before an activity. Stack used since the 
+ * last activity, e.g. by saving the screenshots, is reported.
+*/
+void MemTelemetry::before()
+{
+    sample(_before);
+    if (_valid) compareStacks(_last, _before, "between");
+}
+
+
+/**
+ * Take the sample after the activity name and log what has changed
+*/
+void MemTelemetry::after(const char *name)
+{
+    MemSample s;
+    sample(s);
+    _heapDelta = (int32_t)s.internalFree - (int32_t)_before.internalFree;
+    int32_t psramDelta = (int32_t)s.psramFree - (int32_t)_before.psramFree;
+    if (_heapDelta != 0 || psramDelta != 0)
+        Serial.printf("mem  %-18s heap used %+d bytes, psram used %+d bytes\n", name, -_heapDelta, -psramDelta);
+    compareStacks(_before, s, name);
+
+    int f = fragmentation(s);
+    _rising = _activities > 0 && f > _lastFragmentation ? _rising + 1 : 0;
+    if (_rising >= TREND_RUNS)
+        log_w("fragmentation of the internal heap rising for %d activities: %d%%, largest block %u of %u bytes", 
+              _rising, f, s.internalLargest, s.internalFree);
+    else if (f >= FRAGMENTATION_LIMIT && _lastFragmentation < FRAGMENTATION_LIMIT)
+        log_w("internal heap fragmented %d%%, largest block %u of %u bytes", f, s.internalLargest, s.internalFree);
+    _lastFragmentation = f;
+    _last = s;
+    _valid = true;
+    _activities++;
+}
+
+
+/**
+ * Print the current heap and stack usage
+*/
+void MemTelemetry::print()
+{
+    MemSample s;
+    sample(s);
+    Serial.printf(R"(
+Memory
+------
+          free     largest   min free
+internal  %7u  %7u    %7u   fragmentation %d%%
+dma       %7u  %7u    %7u
+psram     %7u  %7u    %7u
+
+task              stack free
+)", s.internalFree, s.internalLargest, heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT), fragmentation(s),
+    s.dmaFree, s.dmaLargest, heap_caps_get_minimum_free_size(MALLOC_CAP_DMA),
+    s.psramFree, s.psramLargest, heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM));
+    for (int i = 0; i < _nbrTasks; i++)
+        Serial.printf("%-16s  %10u\n", _taskName[i], s.stackFree[i]);
+    Serial.printf("\n");
+}
@@ -0,0 +1,77 @@
+/**
+ * Memory telemetry
+ * 
+ * Samples the free heap of the internal, the DMA capable and the PSRAM 
+ * memory together with the largest free block of each and the stack 
+ * high-water marks of the watched tasks. A sample is taken before and 
+ * after every activity, the differences are logged:
+ * 
+ *  - heap that an activity did not give back (leak or cache growth)
+ *  - stack that a task used deeper than ever before
+ *  - stack used deeper between two activities, e.g. by the screenshots
+ * 
+ * The fragmentation of the internal heap is 1 - largest block / free. 
+ * When it rises over several activities in a row or exceeds a limit 
+ * a warning is logged, before allocations of frame buffers start to 
+ * fail although there is enough free memory in total.
+ * 
+ * The high-water mark of a task is the least free stack it ever had 
+ * (in bytes on the ESP32), it never rises again.
+ * 
+ * Usage    memTelemetry.watch(xTaskGetCurrentTaskHandle(), "loopTask");
+ *          memTelemetry.before();
+ *          runActivity(lcd, i);
+ *          memTelemetry.after(activity[i].name);
+ *          memTelemetry.print();
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+constexpr int MAX_WATCHED_TASKS = 8;
+
+struct MemSample
+{
+    uint32_t internalFree;
+    uint32_t internalLargest;
+    uint32_t dmaFree;
+    uint32_t dmaLargest;
+    uint32_t psramFree;
+    uint32_t psramLargest;
+    uint32_t stackFree[MAX_WATCHED_TASKS];  // high-water marks of the watched tasks
+};
+
+class MemTelemetry
+{
+    public:
+        static constexpr int FRAGMENTATION_LIMIT = 50;  // % of the free internal heap
+        static constexpr int TREND_RUNS = 4;            // rising fragmentation in a row to warn
+        static constexpr int STACK_RESERVE = 256;       // warn below these free stack bytes
+
+        void watch(TaskHandle_t task, const char *name);
+        void sample(MemSample &s);
+        void before();
+        void after(const char *name);
+        void print();
+
+        int32_t heapDelta() const { return _heapDelta; }  // internal heap of the last activity
+        static int fragmentation(const MemSample &s);
+
+    private:
+        void compareStacks(const MemSample &from, const MemSample &to, const char *when);
+
+        TaskHandle_t _task[MAX_WATCHED_TASKS];
+        const char  *_taskName[MAX_WATCHED_TASKS];
+        int          _nbrTasks = 0;
+        MemSample    _before = {}, _last = {};
+        bool         _valid = false;
+        int32_t      _heapDelta = 0;
+        int          _lastFragmentation = 0;
+        int          _rising = 0;
+        uint32_t     _activities = 0;
+};
+
+extern MemTelemetry memTelemetry;
@@ -0,0 +1,3 @@
+#include "RenderStats.h"
+
+RenderCounters renderCounters;
@@ -0,0 +1,41 @@
+/**
+ * Counters of the work sent to the lcd while an activity runs
+ * 
+ * The buffered render paths (e.g. Scanline) add every push they 
+ * do, display lists the primitives they got and sent. The runner 
+ * of the activities resets the counters before and reads them 
+ * after each activity.
+ * 
+ * With LGFX_PROFILE the draw calls of the LGFX class count themselves 
+ * (see DrawProfiler.h). Pushes through the LGFX class are therefore 
+ * added with addPush(), which counts only without the profiler, so 
+ * every push is counted once. Pushes through a plain LovyanGFX, which 
+ * the profiler doesn't see, are always added with add().
+ * 
+ * An activity that waits on purpose, e.g. to show a view for a while, 
+ * adds the time to waitUs, which the runner leaves out of its render 
+ * time.
+*/
+
+#pragma once
+#include <stdint.h>
+
+struct RenderCounters
+{
+    uint32_t primitives   = 0;  // number of draw calls / pushes
+    uint32_t bytesFlushed = 0;  // pixel bytes sent to the panel
+    uint32_t listIn       = 0;  // primitives added to display lists
+    uint32_t listOut      = 0;  // primitives left after compiling the lists
+    uint32_t waitUs       = 0;  // time waited on purpose
+
+    void reset() { primitives = 0; bytesFlushed = 0; listIn = 0; listOut = 0; waitUs = 0; }
+    void add(uint32_t bytes) { primitives++; bytesFlushed += bytes; }
+    void addPush(uint32_t bytes)
+    {
+#ifndef LGFX_PROFILE
+        add(bytes);
+#endif
+    }
+};
+
+extern RenderCounters renderCounters;
@@ -0,0 +1,45 @@
+#include "Rng.h"
+
+uint32_t activitySeed = 1;
+
+/**
+ * Expand seed and stream into the 128 bit state with splitmix64,
+ * which never gives the all zero state of xoshiro
+*/
+void Rng::seed(uint32_t seed, uint32_t stream)
+{
+    uint64_t x = (uint64_t)seed << 32 | stream;
+    for (int i = 0; i < 4; i += 2)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        z ^= z >> 31;
+        _s[i]     = (uint32_t)z;
+        _s[i + 1] = (uint32_t)(z >> 32);
+    }
+}
+
+
+/**
+ * Bulk generation. The state stays in registers for the whole loop 
+ * and the output is written contiguously, so the loop can be unrolled 
+ * and vectorized by the compiler where the target has SIMD.
+*/
+void Rng::fill(uint32_t *dst, int n)
+{
+    Rng r = *this;
+    for (int i = 0; i < n; i++) dst[i] = r.next();
+    *this = r;
+}
+
+
+/**
+ * Fill dst with n numbers 0 <= r < bound, bound <= 65536
+*/
+void Rng::fillBelow(uint16_t *dst, int n, uint32_t bound)
+{
+    Rng r = *this;
+    for (int i = 0; i < n; i++) dst[i] = r.below(bound);
+    *this = r;
+}
@@ -0,0 +1,76 @@
+/**
+ * Fast deterministic pseudo random numbers
+ * 
+ * xoshiro128** by Blackman and Vigna: 128 bit state, 32 bit output, 
+ * only shifts, rotations and one multiplication per number. Much 
+ * faster than random() of the Arduino core, which reads the hardware 
+ * RNG and divides for every call, and reproducible from its seed.
+ * 
+ * A generator is seeded from a 32 bit seed and a stream number 
+ * with splitmix64, so different streams of the same seed (e.g. one 
+ * per worker) are independent of each other.
+ * 
+ * Every activity run gets a seed (see runActivity), activities take 
+ * their generators from activityRng(). With the same seed an activity
+ * draws exactly the same image.
+ * 
+ * Usage    Rng rng = activityRng();
+ *          int x = rng.below(lcd.width());
+*/
+
+#pragma once
+#include <stdint.h>
+
+class Rng
+{
+    public:
+        Rng(uint32_t seed = 1, uint32_t stream = 0) { this->seed(seed, stream); }
+
+        void seed(uint32_t seed, uint32_t stream = 0);
+
+        uint32_t next()
+        {
+            const uint32_t result = rotl(_s[1] * 5, 7) * 9;
+            const uint32_t t = _s[1] << 9;
+            _s[2] ^= _s[0];
+            _s[3] ^= _s[1];
+            _s[1] ^= _s[2];
+            _s[0] ^= _s[3];
+            _s[2] ^= t;
+            _s[3] = rotl(_s[3], 11);
+            return result;
+        }
+
+        /**
+         * Unbiased integer 0 <= r < n by multiply and shift (Lemire). 
+         * Only when the low half of the product falls into the biased 
+         * range, which is rare for small n, another number is drawn.
+        */
+        uint32_t below(uint32_t n)
+        {
+            uint64_t m = (uint64_t)next() * n;
+            if ((uint32_t)m < n)
+            {
+                const uint32_t threshold = -n % n;
+                while ((uint32_t)m < threshold) m = (uint64_t)next() * n;
+            }
+            return m >> 32;
+        }
+
+        int32_t range(int32_t lo, int32_t hi) { return lo + (int32_t)below(hi - lo); }  // lo <= r < hi
+        float   uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }              // 0 <= r < 1
+
+        void fill(uint32_t *dst, int n);
+        void fillBelow(uint16_t *dst, int n, uint32_t bound);
+
+    private:
+        static uint32_t rotl(uint32_t x, int k) { return (x << k) | (x >> (32 - k)); }
+        uint32_t _s[4];
+};
+
+extern uint32_t activitySeed;
+
+/**
+ * Generator for stream number stream of the current activity run
+*/
+inline Rng activityRng(uint32_t stream = 0) { return Rng(activitySeed, stream); }
@@ -0,0 +1,166 @@
+#include "Scanline.h"
+#include "RenderStats.h"
+#include "Hud.h"
+
+uint16_t Scanline::_line[2][MAX_WIDTH];
+
+void Scanline::begin()
+{
+    hud.update(_lcd);       // once per image
+    _lcd.startWrite();
+}
+
+
+void Scanline::end()
+{
+    _lcd.waitDMA();
+    _lcd.endWrite();
+}
+
+
+/**
+ * Push len pixels of the current line buffer to (x, y) and switch 
+ * to the other buffer. The transfer runs in the background, the 
+ * buffer is not touched again before the next flush has started.
+ * The HUD, when it is on, is put into the row before.
+*/
+void Scanline::flush(int x, int y, int len)
+{
+    hud.overlayRow(_line[_current], x, y, len);
+    _lcd.pushImageDMA(x, y, len, 1, (lgfx::swap565_t*)_line[_current]);
+    renderCounters.addPush(2 * len);
+    _current ^= 1;
+}
+
+
+/**
+ * Interpolate between two RGB565 colors channel by channel,
+ * t = 0 .. 65536 (Q16) gives c0 .. c1
+*/
+uint16_t Scanline::lerp565(uint16_t c0, uint16_t c1, int32_t t)
+{
+    int32_t r0 = c0 >> 11, g0 = (c0 >> 5) & 0x3F, b0 = c0 & 0x1F;
+    int32_t r1 = c1 >> 11, g1 = (c1 >> 5) & 0x3F, b1 = c1 & 0x1F;
+    t >>= 8; // Q8 is enough for 6 bit channels and avoids overflow
+    int32_t r = r0 + (((r1 - r0) * t + 128) >> 8);
+    int32_t g = g0 + (((g1 - g0) * t + 128) >> 8);
+    int32_t b = b0 + (((b1 - b0) * t + 128) >> 8);
+    return (r << 11) | (g << 5) | b;
+}
+
+
+/**
+ * Write len interpolated pixels (byte swapped) to dst. The 
+ * interpolation parameter starts at t and advances by dt 
+ * per pixel (Q16), it is clamped to 0 .. 65536.
+*/
+void Scanline::span(uint16_t *dst, int len, uint16_t c0, uint16_t c1, int32_t t, int32_t dt)
+{
+    for (int i = 0; i < len; i++)
+    {
+        int32_t tc = t < 0 ? 0 : (t > 65536 ? 65536 : t);
+        dst[i] = swap(lerp565(c0, c1, tc));
+        t += dt;
+    }
+}
+
+
+/**
+ * Angle of the vector (dx, dy) measured from the positive y axis 
+ * towards the positive x axis as binary angle (65536 = 360°).
+ * Uses atan(t) ~ t * (pi/4 + 0.273 * (1 - t)) within each octant,
+ * the error is below 0.25°.
+*/
+uint16_t Scanline::angle(int dx, int dy)
+{
+    uint32_t ax = abs(dx);
+    uint32_t ay = abs(dy);
+    if (ax == 0 && ay == 0) return 0;
+
+    uint32_t mn = ax < ay ? ax : ay;
+    uint32_t mx = ax < ay ? ay : ax;
+    uint32_t t  = (mn << 15) / mx;                                   // Q15, 0 .. 1
+    uint32_t a  = (t * (8192 + ((2847 * (32768 - t)) >> 15))) >> 15; // 0 .. 8192 = 45°
+    if (ax > ay) a = 16384 - a;                                      // 2nd octant
+    if (dy < 0)  a = 32768 - a;                                      // 2nd quadrant
+    if (dx < 0)  a = 65536 - a;                                      // 3rd and 4th quadrant
+    return a;
+}
+
+
+/**
+ * Fill the rectangle (x, y, w, h) with a linear gradient running 
+ * from color c0 at point (x0, y0) to color c1 at point (x1, y1). 
+ * Pixels before the start point get c0, those after the end point c1.
+*/
+void Scanline::linearGradient(int x, int y, int w, int h, int x0, int y0, uint16_t c0, int x1, int y1, uint16_t c1)
+{
+    int32_t vx = x1 - x0;
+    int32_t vy = y1 - y0;
+    int32_t len2 = vx * vx + vy * vy;
+    if (len2 == 0) len2 = 1;
+    int32_t dt = ((int64_t)vx << 16) / len2;   // advance of t per pixel in x
+
+    w = std::min(w, MAX_WIDTH);
+    for (int row = y; row < y + h; row++)
+    {
+        int32_t t = (((int64_t)(x - x0) * vx + (int64_t)(row - y0) * vy) << 16) / len2;
+        span(line(), w, c0, c1, t, dt);
+        flush(x, row, w);
+    }
+}
+
+
+/**
+ * Fill the rectangle (x, y, w, h) with a radial gradient centered at 
+ * (xm, ym). The color runs from c0 in the center to c1 at the radius,
+ * outside the circle the pixels get the background color bg.
+*/
+void Scanline::radialGradient(int x, int y, int w, int h, int xm, int ym, int radius, uint16_t c0, uint16_t c1, uint16_t bg)
+{
+    int32_t r2 = radius * radius;
+    float scale = 65536.0 / radius;
+    uint16_t bgs = swap(bg);
+
+    w = std::min(w, MAX_WIDTH);
+    for (int row = y; row < y + h; row++)
+    {
+        uint16_t *dst = line();
+        int32_t dy2 = (row - ym) * (row - ym);
+        for (int i = 0; i < w; i++)
+        {
+            int32_t dx = x + i - xm;
+            int32_t d2 = dx * dx + dy2;
+            dst[i] = d2 > r2 ? bgs : swap(lerp565(c0, c1, sqrtf(d2) * scale));
+        }
+        flush(x, row, w);
+    }
+}
+
+
+/**
+ * Fill the rectangle (x, y, w, h) with a conic gradient centered at 
+ * (xm, ym) and limited to the given radius. Each pixel takes the color
+ * of its angle (measured from the positive y axis towards the positive 
+ * x axis) from the palette, which spans a full turn. Outside the circle 
+ * the pixels get the background color bg.
+*/
+void Scanline::conicGradient(int x, int y, int w, int h, int xm, int ym, int radius, const uint16_t *palette, int paletteSize, uint16_t bg)
+{
+    int32_t r2 = radius * radius;
+    uint16_t bgs = swap(bg);
+
+    w = std::min(w, MAX_WIDTH);
+    for (int row = y; row < y + h; row++)
+    {
+        uint16_t *dst = line();
+        int32_t dy  = row - ym;
+        int32_t dy2 = dy * dy;
+        for (int i = 0; i < w; i++)
+        {
+            int32_t dx = x + i - xm;
+            dst[i] = dx * dx + dy2 > r2 ? bgs : swap(palette[(angle(dx, dy) * paletteSize) >> 16]);
+        }
+        flush(x, row, w);
+    }
+}
@@ -0,0 +1,49 @@
+/**
+ * Scanline rasterizer
+ * 
+ * Computes whole rows of RGB565 pixels into a line buffer and pushes 
+ * each row to the lcd with one DMA write. Two line buffers are used 
+ * alternately, so the next row is computed while the previous one 
+ * is still being transferred.
+ * 
+ * The pixels in the line buffers are stored byte swapped, that is
+ * in the order in which the panel expects them. Use swap() when 
+ * writing your own colors into line().
+ * 
+ * Usage    Scanline sl(lcd);
+ *          sl.begin();
+ *          sl.linearGradient(0, 0, lcd.width(), lcd.height(), 0, 0, TFT_RED, 0, 319, TFT_BLUE);
+ *          sl.end();
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+
+class Scanline
+{
+    public:
+        static constexpr int MAX_WIDTH = 320;  // larger dimension of the display
+
+        Scanline(LGFX &lcd) : _lcd(lcd) {}
+
+        void begin();
+        void end();
+        uint16_t *line() { return _line[_current]; }
+        void flush(int x, int y, int len);
+
+        void linearGradient(int x, int y, int w, int h, int x0, int y0, uint16_t c0, int x1, int y1, uint16_t c1);
+        void radialGradient(int x, int y, int w, int h, int xm, int ym, int radius, uint16_t c0, uint16_t c1, uint16_t bg);
+        void conicGradient(int x, int y, int w, int h, int xm, int ym, int radius, const uint16_t *palette, int paletteSize, uint16_t bg);
+
+        static void span(uint16_t *dst, int len, uint16_t c0, uint16_t c1, int32_t t, int32_t dt);
+        static uint16_t lerp565(uint16_t c0, uint16_t c1, int32_t t);
+        static uint16_t swap(uint16_t c) { return (c << 8) | (c >> 8); }
+        static uint16_t angle(int dx, int dy);
+
+    private:
+        LGFX &_lcd;
+        int   _current = 0;
+        static uint16_t _line[2][MAX_WIDTH];
+};
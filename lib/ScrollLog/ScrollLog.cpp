@@ -0,0 +1,96 @@
+#include "ScrollLog.h"
+#include "VScroll.h"
+#include <stdarg.h>
+
+ScrollLog runLog;
+
+constexpr int MARGIN = 2;
+constexpr int STRIDE = (VScroll::MAX_WIDTH + 31) / 32;
+
+static inline uint16_t swap565(uint16_t c) { return (c << 8) | (c >> 8); }
+
+
+/**
+ * Add the formatted text, each line of it becomes a line of the log,
+ * cut to CHARS characters. The oldest lines are dropped.
+*/
+void ScrollLog::printf(const char *format, ...)
+{
+    char buf[160];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(buf, sizeof(buf), format, args);
+    va_end(args);
+    for (const char *s = buf; *s; )
+    {
+        const char *end = strchr(s, '\n');
+        int len = end ? end - s : strlen(s);
+        add(s, len);
+        s += end ? len + 1 : len;
+    }
+}
+
+
+void ScrollLog::add(const char *s, int len)
+{
+    int i = (_first + _count) % LINES;
+    if (_count < LINES) _count++;
+    else _first = (_first + 1) % LINES;
+    if (len > CHARS) len = CHARS;
+    memcpy(_text[i], s, len);
+    _text[i][len] = '\0';
+}
+
+
+/**
+ * Render content row c of the log, the lines are stacked from the top
+*/
+void ScrollLog::row(int c, uint16_t *line, int width, void *ctx)
+{
+    ScrollLog &log = *static_cast<ScrollLog*>(ctx);
+    const uint16_t fg = swap565(FOREGROUND), bg = swap565(BACKGROUND);
+    for (int x = 0; x < width; x++) line[x] = bg;
+    const int lineH = log._font.height();
+    const int n = (c - MARGIN) / lineH;
+    if (c < MARGIN || n >= log._count) return;
+
+    uint32_t mask[STRIDE] = {0};
+    int x = MARGIN;
+    for (const char *s = log._text[(log._first + n) % LINES]; *s; s++)
+    {
+        log._font.drawMask(*s, mask, STRIDE, 1, x, n * lineH + MARGIN - c);
+        x += log._font.advance(*s);
+    }
+    for (x = 0; x < width; x++)
+        if (mask[x >> 5] & (1u << (x & 31))) line[x] = fg;
+}
+
+
+/**
+ * Show the log on the lcd in portrait orientation, scrolled from the 
+ * oldest line down to the newest one, which stays for HOLD_MS. The 
+ * screen is cleared afterwards.
+*/
+void ScrollLog::show(LGFX &lcd)
+{
+    if (! _ready)
+    {
+        _font.setFont(&fonts::DejaVu9);
+        _ready = true;
+    }
+    lcd.setRotation(0);
+    VScroll vs(lcd);
+    if (! vs.begin(0, 0, row, this)) return;
+    const int bottom = _count * _font.height() + 2 * MARGIN - vs.height();
+    for (int offset = SPEED; offset < bottom; offset += SPEED)
+    {
+        uint32_t tick = millis();
+        vs.scrollTo(offset);
+        int32_t wait = TICK_MS - (millis() - tick);
+        if (wait > 0) delay(wait);
+    }
+    if (bottom > 0) vs.scrollTo(bottom);
+    delay(HOLD_MS);
+    vs.end();
+    lcd.fillScreen(BACKGROUND);
+}
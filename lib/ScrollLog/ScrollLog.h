@@ -0,0 +1,45 @@
+/**
+ * Scrolling log on the screen
+ * 
+ * Keeps the last lines written to it, like the render times of the 
+ * activities, and shows them on the lcd as a text column that scrolls 
+ * from the oldest to the newest line with the hardware scrolling of 
+ * the panel (see VScroll.h). Only the rows of the text coming into 
+ * view are rendered, from the glyphs of a small font.
+ * 
+ * Usage    runLog.printf("%s %.1f ms\n", name, ms);
+ *          runLog.show(lcd);
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "GlyphCache.h"
+
+class ScrollLog
+{
+    public:
+        static constexpr int LINES = 64;
+        static constexpr int CHARS = 40;
+        static constexpr int SPEED = 2;               // rows per frame
+        static constexpr uint32_t TICK_MS = 16;
+        static constexpr uint32_t HOLD_MS = 3000;     // on the newest line
+        static constexpr uint16_t FOREGROUND = TFT_GREEN;
+        static constexpr uint16_t BACKGROUND = TFT_BLACK;
+
+        void printf(const char *format, ...) __attribute__((format(printf, 2, 3)));
+        void show(LGFX &lcd);
+        int  lines() const { return _count; }
+
+    private:
+        void add(const char *s, int len);
+        static void row(int c, uint16_t *line, int width, void *ctx);
+
+        GlyphCache &_font = smallGlyphCache;
+        bool _ready = false;
+        char _text[LINES][CHARS + 1];
+        int  _first = 0, _count = 0;      // ring of lines, oldest first
+};
+
+extern ScrollLog runLog;
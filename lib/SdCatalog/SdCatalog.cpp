@@ -0,0 +1,389 @@
+#include "SdCatalog.h"
+#include <esp_heap_caps.h>
+
+SdCatalog sdCatalog;
+
+constexpr uint32_t CATALOG_MAGIC = 0x54414353;  // "SCAT"
+constexpr int MAX_PATH = 256;
+static const char *CATALOG_PATH = "/catalog.idx";
+
+
+SdCatalog::~SdCatalog()
+{
+    clear();
+}
+
+
+void SdCatalog::clear()
+{
+    heap_caps_free(_entry);
+    heap_caps_free(_names);
+    _entry = nullptr;
+    _names = nullptr;
+    _count = _capacity = 0;
+    _nameBytes = _nameCapacity = _freeBytes = 0;
+}
+
+
+/**
+ * FNV-1a hash of the first len characters of path
+*/
+uint32_t SdCatalog::hash(const char *path, size_t len)
+{
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)path[i]) * 16777619u;
+    return h;
+}
+
+
+uint32_t SdCatalog::parentHash(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    if (slash == nullptr || slash == path) return hash("/", 1);
+    return hash(path, slash - path);
+}
+
+
+const char *SdCatalog::baseName(const char *path)
+{
+    const char *slash = strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+
+/**
+ * Grow the entries and the name pool, preferably in PSRAM
+*/
+bool SdCatalog::reserve(int entries, size_t nameBytes)
+{
+    if (entries > _capacity)
+    {
+        int capacity = _capacity ? _capacity : 64;
+        while (capacity < entries) capacity *= 2;
+        size_t size = capacity * sizeof(CatalogEntry);
+        CatalogEntry *e = (CatalogEntry*)heap_caps_realloc(_entry, size, MALLOC_CAP_SPIRAM);
+        if (e == nullptr) e = (CatalogEntry*)heap_caps_realloc(_entry, size, MALLOC_CAP_8BIT);
+        if (e == nullptr) return false;
+        _entry = e;
+        _capacity = capacity;
+    }
+    if (nameBytes > _nameCapacity)
+    {
+        size_t capacity = _nameCapacity ? _nameCapacity : 1024;
+        while (capacity < nameBytes) capacity *= 2;
+        char *n = (char*)heap_caps_realloc(_names, capacity, MALLOC_CAP_SPIRAM);
+        if (n == nullptr) n = (char*)heap_caps_realloc(_names, capacity, MALLOC_CAP_8BIT);
+        if (n == nullptr) return false;
+        _names = n;
+        _nameCapacity = capacity;
+    }
+    return true;
+}
+
+
+/**
+ * Drop the names of removed entries from the pool: the names are 
+ * copied in the order of the entries into a new pool of the size 
+ * they need. Without memory for it the pool stays as it is.
+*/
+void SdCatalog::compactNames()
+{
+    size_t bytes = _nameBytes - _freeBytes;
+    char *n = (char*)heap_caps_malloc(bytes ? bytes : 1, MALLOC_CAP_SPIRAM);
+    if (n == nullptr) n = (char*)heap_caps_malloc(bytes ? bytes : 1, MALLOC_CAP_8BIT);
+    if (n == nullptr) return;
+    size_t offset = 0;
+    for (int i = 0; i < _count; i++)
+    {
+        size_t len = strlen(name(_entry[i])) + 1;
+        memcpy(n + offset, name(_entry[i]), len);
+        _entry[i].name = offset;
+        offset += len;
+    }
+    heap_caps_free(_names);
+    _names = n;
+    _nameBytes = _nameCapacity = offset;
+    _freeBytes = 0;
+}
+
+
+/**
+ * Index of the first entry with a key (parent, hash) not less than the given one
+*/
+int SdCatalog::lowerBound(uint32_t parent, uint32_t hash) const
+{
+    uint64_t key = (uint64_t)parent << 32 | hash;
+    int lo = 0, hi = _count;
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        uint64_t k = (uint64_t)_entry[mid].parent << 32 | _entry[mid].hash;
+        if (k < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+
+int SdCatalog::indexOf(const char *path) const
+{
+    uint32_t parent = parentHash(path);
+    uint32_t h = hash(path, strlen(path));
+    const char *base = baseName(path);
+    for (int i = lowerBound(parent, h); i < _count && _entry[i].parent == parent && _entry[i].hash == h; i++)
+        if (strcmp(name(_entry[i]), base) == 0) return i;
+    return -1;
+}
+
+
+const CatalogEntry *SdCatalog::find(const char *path) const
+{
+    int i = indexOf(path);
+    return i < 0 ? nullptr : &_entry[i];
+}
+
+
+/**
+ * Insert the entry of path or update it when it exists, the catalog 
+ * becomes dirty only when an entry changes
+*/
+void SdCatalog::add(const char *path, ENTRY type, uint32_t size, uint32_t mtime)
+{
+    int i = indexOf(path);
+    if (i >= 0)
+    {
+        if (_entry[i].type == type && _entry[i].size == size && _entry[i].mtime == mtime) return;
+        _dirty = true;
+        _entry[i].type = type;
+        _entry[i].size = size;
+        _entry[i].mtime = mtime;
+        return;
+    }
+
+    const char *base = baseName(path);
+    size_t len = strlen(base) + 1;
+    if (_freeBytes > 0 && _nameBytes + len > _nameCapacity) compactNames();
+    if (! reserve(_count + 1, _nameBytes + len))
+    {
+        log_e("No memory for the catalog entry of %s", path);
+        return;
+    }
+    CatalogEntry e = {};
+    e.parent = parentHash(path);
+    e.hash = hash(path, strlen(path));
+    e.size = size;
+    e.mtime = mtime;
+    e.name = _nameBytes;
+    e.type = type;
+    memcpy(_names + _nameBytes, base, len);
+    _nameBytes += len;
+
+    i = lowerBound(e.parent, e.hash);
+    memmove(&_entry[i + 1], &_entry[i], (_count - i) * sizeof(CatalogEntry));
+    _entry[i] = e;
+    _count++;
+    _dirty = true;
+}
+
+
+/**
+ * Enter the file or directory at path as it is now on the card, 
+ * missing parent directories are entered too. A path that no 
+ * longer exists is removed.
+*/
+void SdCatalog::update(const char *path)
+{
+    if (strcmp(path, CATALOG_PATH) == 0) return;
+    if (strlen(path) >= MAX_PATH)
+    {
+        log_e("Path too long for the catalog: %s", path);
+        return;
+    }
+    File f = SD.open(path);
+    if (! f)
+    {
+        remove(path);
+        return;
+    }
+
+    char dir[MAX_PATH];
+    for (const char *p = strchr(path + 1, '/'); p != nullptr; p = strchr(p + 1, '/'))
+    {
+        size_t len = p - path;
+        memcpy(dir, path, len);
+        dir[len] = '\0';
+        if (indexOf(dir) < 0) add(dir, ENTRY::DIR, 0, 0);
+    }
+    if (f.isDirectory()) add(path, ENTRY::DIR, 0, f.getLastWrite());
+    else add(path, ENTRY::FILE, f.size(), f.getLastWrite());
+    f.close();
+}
+
+
+/**
+ * Remove the entry of path, for a directory with all its content
+*/
+void SdCatalog::remove(const char *path)
+{
+    int i = indexOf(path);
+    if (i < 0) return;
+    if (_entry[i].type == ENTRY::DIR)
+    {
+        uint32_t h = _entry[i].hash;
+        char child[MAX_PATH];
+        int j;
+        while ((j = lowerBound(h, 0)) < _count && _entry[j].parent == h)
+        {
+            int before = _count;
+            snprintf(child, sizeof(child), "%s/%s", path, name(_entry[j]));
+            remove(child);
+            if (_count == before) break;    // name too long to rebuild the path
+        }
+        i = indexOf(path);
+    }
+    _freeBytes += strlen(name(_entry[i])) + 1;
+    memmove(&_entry[i], &_entry[i + 1], (_count - i - 1) * sizeof(CatalogEntry));
+    _count--;
+    _dirty = true;
+}
+
+
+void SdCatalog::scan(File &dir)
+{
+    while (true)
+    {
+        File entry = dir.openNextFile();
+        if (! entry) break;
+        const char *path = entry.path();
+        if (strcmp(path, CATALOG_PATH) != 0)
+        {
+            if (entry.isDirectory())
+            {
+                add(path, ENTRY::DIR, 0, entry.getLastWrite());
+                scan(entry);
+            }
+            else add(path, ENTRY::FILE, entry.size(), entry.getLastWrite());
+        }
+        entry.close();
+    }
+}
+
+
+/**
+ * Scan the whole card
+*/
+void SdCatalog::rebuild()
+{
+    uint32_t start = millis();
+    clear();
+    File root = SD.open("/");
+    if (! root)
+    {
+        log_e("Can't open the root directory");
+        return;
+    }
+    scan(root);
+    root.close();
+    _dirty = true;
+    log_i("%d entries scanned in %u ms", _count, millis() - start);
+}
+
+
+bool SdCatalog::load()
+{
+    File f = SD.open(CATALOG_PATH);
+    if (! f) return false;
+
+    Header h;
+    bool ok = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && h.magic == CATALOG_MAGIC && h.version == VERSION;
+    if (ok && h.usedBytes != SD.usedBytes())
+    {
+        log_i("The card has changed, the catalog is out of date");
+        ok = false;
+    }
+    if (ok)
+    {
+        clear();
+        ok = reserve(h.count, h.nameBytes);
+        size_t entryBytes = h.count * sizeof(CatalogEntry);
+        ok = ok && f.read((uint8_t*)_entry, entryBytes) == entryBytes 
+                && f.read((uint8_t*)_names, h.nameBytes) == h.nameBytes;
+        if (ok)
+        {
+            _count = h.count;
+            _nameBytes = h.nameBytes;
+        }
+        else clear();
+    }
+    f.close();
+    _dirty = false;
+    return ok;
+}
+
+
+/**
+ * Load the catalog, or scan the card and save a new one
+*/
+bool SdCatalog::begin()
+{
+    uint32_t start = millis();
+    if (load())
+    {
+        log_i("%d entries loaded in %u ms", _count, millis() - start);
+        return true;
+    }
+    rebuild();
+    return save();
+}
+
+
+/**
+ * Write the catalog to the card if it has changed. The names of 
+ * removed entries are dropped from the pool first when they take more 
+ * than a quarter of it. The used bytes of the card are known only 
+ * after writing, they are put into the header at last.
+*/
+bool SdCatalog::save()
+{
+    if (! _dirty) return true;
+    File f = SD.open(CATALOG_PATH, FILE_WRITE);
+    if (! f)
+    {
+        log_e("Can't write %s", CATALOG_PATH);
+        return false;
+    }
+
+    if (_freeBytes > _nameBytes / 4) compactNames();
+    Header h = { CATALOG_MAGIC, VERSION, 0, (uint32_t)_count, (uint32_t)_nameBytes, 0 };
+    f.write((uint8_t*)&h, sizeof(h));
+    f.write((uint8_t*)_entry, _count * sizeof(CatalogEntry));
+    f.write((uint8_t*)_names, _nameBytes);
+    f.close();
+
+    h.usedBytes = SD.usedBytes();
+    f = SD.open(CATALOG_PATH, "r+");
+    if (! f) return false;
+    f.write((uint8_t*)&h, sizeof(h));
+    f.close();
+    _dirty = false;
+    return true;
+}
+
+
+/**
+ * Print the entries of the directory dir
+*/
+void SdCatalog::list(const char *dir) const
+{
+    size_t len = strlen(dir);
+    if (len > 1 && dir[len - 1] == '/') len--;
+    uint32_t h = hash(dir, len);
+    int n = 0;
+    for (int i = lowerBound(h, 0); i < _count && _entry[i].parent == h; i++, n++)
+    {
+        const CatalogEntry &e = _entry[i];
+        if (e.type == ENTRY::DIR) Serial.printf("    %s/\n", name(e));
+        else Serial.printf("    %s, %u\n", name(e), e.size);
+    }
+    Serial.printf("%d entries in %.*s\n", n, (int)len, dir);
+}
@@ -0,0 +1,99 @@
+/**
+ * Catalog of the files on the SD card
+ * 
+ * Walking the card with openNextFile() gets slower with every file in 
+ * the screenshot folders. The catalog keeps one compact entry per file 
+ * and directory in RAM and on the card in /catalog.idx, so the card is 
+ * scanned only when the catalog is missing or out of date.
+ * 
+ * An entry holds the hash of its path and of the path of its parent 
+ * directory, size, time of the last write, type and the offset of its 
+ * name in a pool of names. The entries are sorted by (parent, hash): 
+ * a path is found with a binary search, the entries of a directory 
+ * are one contiguous range. Paths start with '/' and have no trailing 
+ * '/', the root is "/".
+ * 
+ * Files written by the program are entered with update(), the catalog
+ * file is rewritten by save() when something has changed. It stores 
+ * the used bytes of the card; when they don't match at boot, e.g. after 
+ * the card was changed on a PC, the card is scanned again.
+ * 
+ * File       "SCAT", version (2 bytes), 0 (2 bytes), count, name bytes, 
+ *            used bytes of the card (8 bytes), entries, names
+ * 
+ * Usage    sdCatalog.begin();
+ *          saveBmpToSD_16bit(lcd, "/00_RGB_Tiles_16.bmp");
+ *          sdCatalog.update("/00_RGB_Tiles_16.bmp");
+ *          sdCatalog.save();
+ *          sdCatalog.list("/traces");
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+
+enum class ENTRY : uint8_t { FILE, DIR };
+
+struct CatalogEntry
+{
+    uint32_t parent;    // hash of the path of the directory
+    uint32_t hash;      // hash of the path
+    uint32_t size;
+    uint32_t mtime;     // time of the last write
+    uint32_t name;      // offset of the name in the name pool
+    ENTRY    type;
+    uint8_t  reserved[3];
+};
+
+class SdCatalog
+{
+    public:
+        static constexpr uint16_t VERSION = 1;
+
+        ~SdCatalog();
+
+        bool begin();
+        void rebuild();
+        void update(const char *path);
+        void remove(const char *path);
+        bool save();
+
+        const CatalogEntry *find(const char *path) const;
+        const char *name(const CatalogEntry &e) const { return _names + e.name; }
+        void list(const char *dir) const;
+        int  count() const { return _count; }
+        bool isDirty() const { return _dirty; }
+
+        static uint32_t hash(const char *path, size_t len);
+
+    private:
+        struct Header
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint16_t reserved;
+            uint32_t count;
+            uint32_t nameBytes;
+            uint64_t usedBytes;
+        };
+
+        bool load();
+        void clear();
+        void scan(File &dir);
+        void add(const char *path, ENTRY type, uint32_t size, uint32_t mtime);
+        int  lowerBound(uint32_t parent, uint32_t hash) const;
+        int  indexOf(const char *path) const;
+        bool reserve(int entries, size_t nameBytes);
+        void compactNames();
+        static uint32_t parentHash(const char *path);
+        static const char *baseName(const char *path);
+
+        CatalogEntry *_entry = nullptr;
+        int    _count = 0, _capacity = 0;
+        char  *_names = nullptr;
+        size_t _nameBytes = 0, _nameCapacity = 0;
+        size_t _freeBytes = 0;      // names of removed entries in the pool
+        bool   _dirty = false;
+};
+
+extern SdCatalog sdCatalog;
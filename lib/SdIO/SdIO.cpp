@@ -0,0 +1,227 @@
+#include "SdIO.h"
+#include "Arena.h"
+#include <esp_heap_caps.h>
+
+uint32_t sdClock = 0;
+
+static const uint32_t sdClocks[] = { 40000000, 26666667, 20000000, 10000000, 4000000 };
+static const char *PROBE_PATH = "/sdprobe.tmp";
+constexpr size_t PROBE_SIZE = 16 * 1024;
+
+
+/**
+ * Write a pattern of PROBE_SIZE bytes and read it back
+*/
+static bool probeCard()
+{
+    uint8_t block[512];
+    File f = SD.open(PROBE_PATH, FILE_WRITE);
+    if (! f) return false;
+    bool ok = true;
+    for (size_t n = 0; n < PROBE_SIZE && ok; n += sizeof(block))
+    {
+        for (size_t i = 0; i < sizeof(block); i++) block[i] = (n + i) * 31 >> 3;
+        ok = f.write(block, sizeof(block)) == sizeof(block);
+    }
+    f.close();
+
+    f = SD.open(PROBE_PATH);
+    ok = ok && f;
+    for (size_t n = 0; n < PROBE_SIZE && ok; n += sizeof(block))
+    {
+        ok = f.read(block, sizeof(block)) == sizeof(block);
+        for (size_t i = 0; i < sizeof(block) && ok; i++) ok = block[i] == (uint8_t)((n + i) * 31 >> 3);
+    }
+    if (f) f.close();
+    SD.remove(PROBE_PATH);
+    return ok;
+}
+
+
+/**
+ * Mount the card at the fastest clock that passes the probe
+*/
+bool beginSdCard(SPIClass &spi)
+{
+    sdClock = 0;
+    for (uint32_t clock : sdClocks)
+    {
+        if (! SD.begin(TF_CS, spi, clock)) 
+        {
+            log_e("SD.begin failed at %u kHz", clock / 1000);
+            SD.end();
+            continue;
+        }
+        if (clock == sdClocks[sizeof(sdClocks) / sizeof(sdClocks[0]) - 1] || probeCard())
+        {
+            sdClock = clock;
+            log_i("SD card at %u kHz", clock / 1000);
+            return true;
+        }
+        log_e("Transfer errors at %u kHz, trying a slower clock", clock / 1000);
+        SD.end();
+    }
+    return false;
+}
+
+
+/**
+ * Open path for writing. With the final size of the file given, its 
+ * clusters are allocated at once by seeking to its end.
+*/
+bool SdWriter::open(const char *path, uint32_t size)
+{
+    close();
+    _hold.take();
+    _buf = frameArena.alloc<uint8_t>(BUFFER_SIZE);
+    if (_buf == nullptr) _buf = (uint8_t*)heap_caps_malloc(BUFFER_SIZE, MALLOC_CAP_DMA);
+    if (_buf == nullptr)
+    {
+        log_e("No memory for the write buffer");
+        _hold.release();
+        return false;
+    }
+    _file = SD.open(path, FILE_WRITE);
+    if (! _file)
+    {
+        log_e("%s can't be opened", path);
+        releaseBuffer();
+        return false;
+    }
+    if (size > 0 && ! (_file.seek(size) && _file.seek(0)))
+        log_e("%s can't be preallocated", path);
+    _fill = 0;
+    _bytes = 0;
+    _ok = true;
+    return true;
+}
+
+
+bool SdWriter::flushBuffer()
+{
+    if (_fill == 0) return _ok;
+    if (_file.write(_buf, _fill) != _fill) _ok = false;
+    _fill = 0;
+    return _ok;
+}
+
+
+size_t SdWriter::write(const void *data, size_t len)
+{
+    if (_buf == nullptr || ! _ok) return 0;
+    const uint8_t *p = (const uint8_t*)data;
+    size_t left = len;
+    while (left > 0)
+    {
+        size_t n = BUFFER_SIZE - _fill < left ? BUFFER_SIZE - _fill : left;
+        memcpy(_buf + _fill, p, n);
+        _fill += n;
+        p += n;
+        left -= n;
+        if (_fill == BUFFER_SIZE && ! flushBuffer()) return len - left;
+    }
+    _bytes += len;
+    return len;
+}
+
+
+void SdWriter::releaseBuffer()
+{
+    if (! frameArena.contains(_buf)) heap_caps_free(_buf);
+    _buf = nullptr;
+    _hold.release();
+}
+
+
+/**
+ * Write the rest of the buffer and close the file. 
+ * Returns false when a write failed.
+*/
+bool SdWriter::close()
+{
+    if (_buf == nullptr) return false;
+    flushBuffer();
+    _file.close();
+    releaseBuffer();
+    return _ok;
+}
+
+
+/**
+ * Print a histogram of the latencies of the operations
+*/
+static void printHistogram(const char *title, const uint32_t *bucket, int buckets)
+{
+    Serial.printf("%-8s", title);
+    for (int i = 0; i < buckets; i++) Serial.printf(" %6u", bucket[i]);
+    Serial.printf("\n");
+}
+
+
+/**
+ * Write and read a test file of kBytes with chunks of 512 bytes to 
+ * 16 KB and print the throughput and the latencies per operation
+*/
+void sdBenchmark(uint32_t kBytes)
+{
+    const char *path = "/sdbench.tmp";
+    const size_t chunks[] = { 512, 4096, 16384 };
+    constexpr int BUCKETS = 8;      // < 0.25, 0.5, 1, 2, 4, 8, 16 ms, longer
+    uint32_t size = kBytes * 1024;
+
+    ArenaScope scope(frameArena);
+    uint8_t *buf = frameArena.alloc<uint8_t>(16384);
+    if (buf == nullptr)
+    {
+        Serial.printf("not enough memory for the benchmark\n");
+        return;
+    }
+    for (size_t i = 0; i < 16384; i++) buf[i] = i;
+
+    Serial.printf("\nSD card at %u kHz, %u KB per test\n", sdClock / 1000, kBytes);
+    Serial.printf("chunk     write MB/s   read MB/s\n");
+    uint32_t histogram[3][2][BUCKETS] = {};
+    for (int c = 0; c < 3; c++)
+    {
+        size_t chunk = chunks[c];
+        uint32_t writeUs = 0, readUs = 0;
+        for (int pass = 0; pass < 2; pass++)
+        {
+            File f = SD.open(path, pass == 0 ? FILE_WRITE : FILE_READ);
+            if (! f)
+            {
+                Serial.printf("%s can't be opened\n", path);
+                return;
+            }
+            if (pass == 0) { f.seek(size); f.seek(0); }
+            uint32_t start = micros();
+            for (uint32_t n = 0; n < size; n += chunk)
+            {
+                size_t len = std::min<uint32_t>(chunk, size - n);     // the last one may be shorter
+                uint32_t t = micros();
+                if (pass == 0) f.write(buf, len);
+                else f.read(buf, len);
+                uint32_t us = micros() - t;
+                int b = 0;
+                while (b < BUCKETS - 1 && us >= (250u << b)) b++;
+                histogram[c][pass][b]++;
+            }
+            f.close();
+            (pass == 0 ? writeUs : readUs) = micros() - start;
+        }
+        Serial.printf("%5u  %11.2f %11.2f\n", chunk, 
+                      (float)size / (writeUs ? writeUs : 1), (float)size / (readUs ? readUs : 1));
+    }
+    SD.remove(path);
+
+    Serial.printf("\nlatency   <0.25   <0.5     <1     <2     <4     <8    <16   more ms\n");
+    char title[16];
+    for (int c = 0; c < 3; c++)
+    {
+        snprintf(title, sizeof(title), "w %u", chunks[c]);
+        printHistogram(title, histogram[c][0], BUCKETS);
+        snprintf(title, sizeof(title), "r %u", chunks[c]);
+        printHistogram(title, histogram[c][1], BUCKETS);
+    }
+    Serial.printf("\n");
+}
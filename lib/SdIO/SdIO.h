@@ -0,0 +1,65 @@
+/**
+ * SD card I/O
+ * 
+ * beginSdCard() mounts the card at the highest SPI clock at which it 
+ * works reliably. Starting with the fastest clock, a test pattern is 
+ * written and read back; on a transfer or CRC error or a mismatch the 
+ * next slower clock is tried, down to the 4 MHz default. The probe 
+ * runs only when the card is mounted: a later error is reported by 
+ * SdWriter::close(), the clock isn't stepped down at run time.
+ * 
+ * SdWriter writes a file through a 4 KB buffer from the frame arena. 
+ * Whole buffers start at multiples of 4 KB in the file, so the FAT 
+ * driver writes complete sectors with multi-block commands directly 
+ * from the buffer instead of sector by sector through its cache. When 
+ * the size of the file is known it is allocated before writing, which 
+ * saves updating the FAT for every new cluster.
+ * 
+ * Usage    SdWriter w;
+ *          if (w.open("/image.bmp", fileSize))
+ *          {
+ *              w.write(&header, sizeof(header));
+ *              w.write(row, rowSize);
+ *              w.close();
+ *          }
+ * 
+ *          sdBenchmark(1024);   // write and read 1 MB with different chunk sizes
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include <SPI.h>
+#include "Arena.h"
+
+extern uint32_t sdClock;    // clock found by beginSdCard(), 0 without card
+
+bool beginSdCard(SPIClass &spi);
+void sdBenchmark(uint32_t kBytes);
+
+class SdWriter
+{
+    public:
+        static constexpr size_t BUFFER_SIZE = 4096;
+
+        SdWriter() {}
+        ~SdWriter() { close(); }
+        SdWriter(const SdWriter&) = delete;
+        SdWriter &operator=(const SdWriter&) = delete;
+
+        bool   open(const char *path, uint32_t size = 0);
+        size_t write(const void *data, size_t len);
+        bool   close();
+        uint32_t bytes() const { return _bytes; }
+
+    private:
+        bool flushBuffer();
+        void releaseBuffer();
+
+        File     _file;
+        uint8_t *_buf = nullptr;
+        size_t   _fill = 0;
+        ArenaHold _hold{frameArena};
+        uint32_t _bytes = 0;
+        bool     _ok = false;
+};
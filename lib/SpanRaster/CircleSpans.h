@@ -0,0 +1,54 @@
+/**
+ * Half width tables of filled circles
+ * 
+ * Row dy of a filled circle of radius r spans x - hw .. x + hw with 
+ * hw = circleHalfWidth(r, dy). A pixel belongs to the circle when 
+ * dx^2 + dy^2 <= r^2 + r, that is inside the radius r + 1/2, the 
+ * boundary of the midpoint circle algorithm.
+ * 
+ * The tables for r <= 32 are generated at compile time. The rows of 
+ * all radii are stored one after the other, radius r starts at 
+ * r * (r + 1) / 2 and has r + 1 rows (dy = 0 .. r), 561 bytes in total.
+ * The C++11 compiler of the ESP32 has no std::index_sequence, so 
+ * the indices are generated by a small template of our own.
+*/
+
+#pragma once
+#include <stdint.h>
+
+constexpr int MAX_TABLE_RADIUS = 32;
+
+namespace spans
+{
+    template<int... I> struct Indices {};
+    template<int N, int... I> struct MakeIndices : MakeIndices<N - 1, N - 1, I...> {};
+    template<int... I> struct MakeIndices<0, I...> { using type = Indices<I...>; };
+
+    constexpr int start(int r) { return r * (r + 1) / 2; }
+    constexpr int radiusOf(int i, int r = 0) { return start(r + 1) > i ? r : radiusOf(i, r + 1); }
+    constexpr int isqrt(int n, int lo = 0, int hi = 64) 
+    { 
+        return hi - lo <= 1 ? lo : (lo + hi) / 2 * ((lo + hi) / 2) <= n ? isqrt(n, (lo + hi) / 2, hi) : isqrt(n, lo, (lo + hi) / 2);
+    }
+    constexpr uint8_t halfWidth(int r, int dy) { return isqrt(r * r - dy * dy + r); }
+    constexpr uint8_t entry(int i) { return halfWidth(radiusOf(i), i - start(radiusOf(i))); }
+
+    template<class> struct Table;
+    template<int... I> struct Table<Indices<I...>>
+    {
+        static constexpr uint8_t hw[sizeof...(I)] = { entry(I)... };
+    };
+    template<int... I> constexpr uint8_t Table<Indices<I...>>::hw[sizeof...(I)];
+
+    using CircleTable = Table<MakeIndices<start(MAX_TABLE_RADIUS + 1)>::type>;
+}
+
+/**
+ * Half width of row dy of a circle of radius r, 0 <= dy <= r <= MAX_TABLE_RADIUS
+*/
+inline int circleHalfWidth(int r, int dy)
+{
+    return spans::CircleTable::hw[spans::start(r) + dy];
+}
+
+static_assert(spans::halfWidth(0, 0) == 0 && spans::halfWidth(1, 1) == 1 && spans::halfWidth(5, 5) == 2, "circle half widths");
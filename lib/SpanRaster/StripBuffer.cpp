@@ -0,0 +1,103 @@
+#include "StripBuffer.h"
+#include "CircleSpans.h"
+#include "RenderStats.h"
+#include "Arena.h"
+#include <esp_heap_caps.h>
+
+static inline uint16_t swap565(uint16_t c) { return (c >> 8) | (c << 8); }
+
+bool StripBuffer::begin()
+{
+    _width = _lcd.width();
+    _hold.take();
+    for (int i = 0; i < 2; i++)
+    {
+        _buf[i] = frameArena.alloc<uint16_t>(_width * _rows);
+        if (_buf[i] == nullptr) 
+            _buf[i] = (uint16_t*)heap_caps_malloc(_width * _rows * sizeof(uint16_t), MALLOC_CAP_DMA);
+        if (_buf[i] == nullptr)
+        {
+            log_e("No DMA memory for a strip of %d x %d", _width, _rows);
+            release();
+            return false;
+        }
+    }
+    _current = 0;
+    _lcd.startWrite();
+    return true;
+}
+
+
+void StripBuffer::end()
+{
+    _lcd.waitDMA();
+    _lcd.endWrite();
+    release();
+}
+
+
+void StripBuffer::release()
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (! frameArena.contains(_buf[i])) heap_caps_free(_buf[i]);
+        _buf[i] = nullptr;
+    }
+    _hold.release();
+}
+
+
+/**
+ * Start the strip at row y and fill it with the background
+*/
+void StripBuffer::start(int y, uint16_t background)
+{
+    _y = y;
+    _h = _lcd.height() - y < _rows ? _lcd.height() - y : _rows;
+    uint16_t c = swap565(background);
+    uint16_t *p = _buf[_current];
+    for (int i = 0; i < _width * _h; i++) p[i] = c;
+}
+
+
+void StripBuffer::span(int x0, int x1, int y, uint16_t color)
+{
+    if (y < _y || y >= _y + _h) return;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= _width) x1 = _width - 1;
+    uint16_t c = swap565(color);
+    uint16_t *p = _buf[_current] + (y - _y) * _width;
+    for (int x = x0; x <= x1; x++) p[x] = c;
+}
+
+
+/**
+ * Only the rows of the circle inside the strip are visited. 
+ * Radii up to MAX_TABLE_RADIUS take the half widths from the 
+ * compile time table, larger ones compute them.
+*/
+void StripBuffer::fillCircle(int x, int y, int r, uint16_t color)
+{
+    int y0 = y - r < _y ? _y : y - r;
+    int y1 = y + r >= _y + _h ? _y + _h - 1 : y + r;
+    if (y0 > y1 || x + r < 0 || x - r >= _width) return;
+
+    for (int yy = y0; yy <= y1; yy++)
+    {
+        int dy = yy > y ? yy - y : y - yy;
+        int hw = r <= MAX_TABLE_RADIUS ? circleHalfWidth(r, dy) : (int)sqrtf(r * r - dy * dy + r);
+        span(x - hw, x + hw, yy, color);
+    }
+}
+
+
+/**
+ * Push the strip and continue in the other buffer. The transfer 
+ * runs in the background, the next pushImageDMA waits for it.
+*/
+void StripBuffer::flush()
+{
+    _lcd.pushImageDMA(0, _y, _width, _h, (lgfx::swap565_t*)_buf[_current]);
+    renderCounters.addPush(2 * _width * _h);
+    _current ^= 1;
+}
@@ -0,0 +1,61 @@
+/**
+ * Strip buffer
+ * 
+ * A band of full width rows in RAM into which filled shapes are 
+ * rasterized as horizontal spans. A finished strip is pushed to 
+ * the lcd with one DMA write, so many shapes go out in a single 
+ * transfer instead of one transaction per span.
+ * 
+ * Shapes are clipped to the current strip. To draw a whole screen, 
+ * the same sequence of shapes is drawn once per strip:
+ * 
+ * Usage    StripBuffer sb(lcd);
+ *          sb.begin();
+ *          for (int y = 0; y < lcd.height(); y += sb.rows())
+ *          {
+ *              sb.start(y, TFT_BLACK);
+ *              sb.fillCircle(x, y, r, color);   // all circles
+ *              sb.flush();
+ *          }
+ *          sb.end();
+ * 
+ * Two strips are allocated from the frame arena (DMA capable memory), 
+ * one is filled while the other is transferred.
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "Arena.h"
+
+class StripBuffer
+{
+    public:
+        static constexpr int DEFAULT_ROWS = 16;
+
+        StripBuffer(LGFX &lcd, int rows = DEFAULT_ROWS) : _lcd(lcd), _rows(rows) {}
+        ~StripBuffer() { release(); }
+
+        bool begin();
+        void end();
+        int  rows() const { return _rows; }
+        int  top() const { return _y; }
+        int  bottom() const { return _y + _h; }
+
+        void start(int y, uint16_t background);
+        void span(int x0, int x1, int y, uint16_t color);
+        void fillCircle(int x, int y, int r, uint16_t color);
+        void flush();
+
+    private:
+        void release();
+
+        LGFX &_lcd;
+        int _rows;
+        int _width = 0;
+        int _y = 0, _h = 0;
+        uint16_t *_buf[2] = { nullptr, nullptr };
+        ArenaHold _hold{frameArena};
+        int _current = 0;
+};
@@ -0,0 +1,210 @@
+#include "ThumbAtlas.h"
+#include "Arena.h"
+#include "SdCatalog.h"
+#include <esp_heap_caps.h>
+
+ThumbAtlas thumbAtlas;
+
+constexpr uint32_t ATLAS_MAGIC = 0x424D4854;   // "THMB"
+constexpr uint16_t ATLAS_VERSION = 2;
+static const char *ATLAS_PATH = "/thumbs.bin";
+
+static inline uint16_t swap565(uint16_t c) { return (c << 8) | (c >> 8); }
+
+
+bool ThumbAtlas::readHeader(File &f)
+{
+    return f.read((uint8_t*)&_header, sizeof(_header)) == sizeof(_header)
+           && _header.magic == ATLAS_MAGIC && _header.version == ATLAS_VERSION
+           && _header.w == W && _header.h == H && _header.slots <= MAX_SLOTS
+           && _header.table == _table;
+}
+
+
+/**
+ * Start the thumbnail of an image of width x height pixels when one
+ * was requested and the image has the size of the portrait screen
+*/
+bool ThumbAtlas::begin(int width, int height)
+{
+    _slot = _request;
+    _request = -1;
+    _pixels = nullptr;
+    _sumRow = -1;
+    if (_slot < 0 || _slot >= MAX_SLOTS || width != W * SCALE || height != H * SCALE) return false;
+    _pixels = frameArena.alloc<uint16_t>(PIXELS);
+    return _pixels != nullptr;
+}
+
+
+/**
+ * Add row y of the image (RGB565) to the box sums. The rows of a box
+ * must come one after the other, in either direction.
+*/
+void ThumbAtlas::addRow(const uint16_t *row, int y)
+{
+    if (_pixels == nullptr) return;
+    const int ty = y / SCALE;
+    if (ty != _sumRow)
+    {
+        memset(_r, 0, sizeof(_r));
+        memset(_g, 0, sizeof(_g));
+        memset(_b, 0, sizeof(_b));
+        _sumRow = ty;
+        _rows = 0;
+    }
+    for (int x = 0; x < W; x++)
+    {
+        for (int i = 0; i < SCALE; i++)
+        {
+            uint16_t c = *row++;
+            _r[x] += c >> 11;
+            _g[x] += (c >> 5) & 0x3F;
+            _b[x] += c & 0x1F;
+        }
+    }
+    if (++_rows < SCALE) return;
+
+    constexpr int N = SCALE * SCALE;
+    uint16_t *dst = _pixels + ty * W;
+    for (int x = 0; x < W; x++)
+    {
+        uint16_t c = ((_r[x] + N / 2) / N) << 11 | ((_g[x] + N / 2) / N) << 5 | (_b[x] + N / 2) / N;
+        dst[x] = swap565(c);
+    }
+}
+
+
+/**
+ * Write the finished thumbnail into its slot of the atlas. A missing
+ * or outdated atlas, or one of another table, is created anew, slots between the last one and
+ * the new one are filled with zeros. The pixels are in the frame arena,
+ * so finish() must come before the caller releases it.
+*/
+bool ThumbAtlas::finish()
+{
+    if (_pixels == nullptr) return false;
+    uint16_t *pixels = _pixels;
+    _pixels = nullptr;
+
+    File f = SD.open(ATLAS_PATH, "r+");
+    if (! f || ! readHeader(f))
+    {
+        if (f) f.close();
+        _header = { ATLAS_MAGIC, ATLAS_VERSION, W, H, 0, 0, _table, {} };
+        f = SD.open(ATLAS_PATH, FILE_WRITE);
+        if (! f)
+        {
+            log_e("Can't create %s", ATLAS_PATH);
+            return false;
+        }
+        f.write((uint8_t*)&_header, sizeof(_header));
+    }
+
+    bool ok = true;
+    if (_slot >= _header.slots)
+    {
+        // extend the file up to the new slot
+        uint8_t zero[256] = {0};
+        uint32_t size = sizeof(Header) + (uint32_t)_header.slots * SLOT_SIZE;
+        uint32_t end  = sizeof(Header) + (uint32_t)_slot * SLOT_SIZE;
+        ok = f.seek(size);
+        for (; ok && size < end; size += sizeof(zero))
+            ok = f.write(zero, std::min<uint32_t>(sizeof(zero), end - size)) > 0;
+        _header.slots = _slot + 1;
+    }
+    ok = ok && f.seek(sizeof(Header) + (uint32_t)_slot * SLOT_SIZE)
+            && f.write((uint8_t*)pixels, SLOT_SIZE) == SLOT_SIZE;
+    if (ok) _header.valid[_slot >> 5] |= 1u << (_slot & 31);
+    ok = ok && f.seek(0) && f.write((uint8_t*)&_header, sizeof(_header)) == sizeof(_header);
+    f.close();
+    if (! ok) log_e("Thumbnail %d not written", _slot);
+    sdCatalog.update(ATLAS_PATH);
+    return ok;
+}
+
+
+/**
+ * Open the atlas for row(). With enough PSRAM all slots are loaded
+ * at once, otherwise the file stays open for the cache.
+*/
+bool ThumbAtlas::open()
+{
+    close();
+    _file = SD.open(ATLAS_PATH, FILE_READ);
+    if (! _file || ! readHeader(_file))
+    {
+        if (_file) _file.close();
+        _header.slots = 0;
+        return false;
+    }
+    const uint32_t bytes = (uint32_t)_header.slots * SLOT_SIZE;
+    if (heap_caps_get_largest_free_block(MALLOC_CAP_SPIRAM) > bytes)
+        _all = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    if (_all)
+    {
+        uint32_t start = millis();
+        if (_file.read((uint8_t*)_all, bytes) != bytes)
+        {
+            log_e("%s is truncated", ATLAS_PATH);
+            memset(_header.valid, 0, sizeof(_header.valid));
+        }
+        _file.close();
+        log_i("%d thumbnails loaded in %u ms", _header.slots, millis() - start);
+    }
+    else
+    {
+        _hold.take();
+        _cache = frameArena.alloc<uint16_t>(CACHE_SLOTS * PIXELS);
+        for (int i = 0; i < CACHE_SLOTS; i++) { _cached[i] = -1; _used[i] = 0; }
+    }
+    _open = true;
+    return true;
+}
+
+
+/**
+ * Row y of the thumbnail in slot, nullptr when there is none. Without
+ * PSRAM the slot is read into the least recently used cache entry.
+*/
+const uint16_t *ThumbAtlas::row(int slot, int y)
+{
+    if (! _open || ! valid(slot) || y < 0 || y >= H) return nullptr;
+    if (_all) return _all + slot * PIXELS + y * W;
+    if (_cache == nullptr) return nullptr;
+
+    int victim = 0;
+    for (int i = 0; i < CACHE_SLOTS; i++)
+    {
+        if (_cached[i] == slot)
+        {
+            _used[i] = ++_clock;
+            return _cache + i * PIXELS + y * W;
+        }
+        if (_used[i] < _used[victim]) victim = i;     // empty entries have 0
+    }
+    uint16_t *dst = _cache + victim * PIXELS;
+    if (! _file.seek(sizeof(Header) + (uint32_t)slot * SLOT_SIZE)
+        || _file.read((uint8_t*)dst, SLOT_SIZE) != SLOT_SIZE)
+    {
+        _header.valid[slot >> 5] &= ~(1u << (slot & 31));
+        _cached[victim] = -1;
+        _used[victim] = 0;
+        return nullptr;
+    }
+    _cached[victim] = slot;
+    _used[victim] = ++_clock;
+    return dst + y * W;
+}
+
+
+void ThumbAtlas::close()
+{
+    if (! _open) return;
+    if (_file) _file.close();
+    if (_all) heap_caps_free(_all);
+    _hold.release();
+    _all = nullptr;
+    _cache = nullptr;
+    _open = false;
+}
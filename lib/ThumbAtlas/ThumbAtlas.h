@@ -0,0 +1,95 @@
+/**
+ * Thumbnails of the activities
+ *
+ * A menu needs a small preview of every activity, reading and scaling
+ * the full bitmaps of 150 KB for that would take seconds. Instead the
+ * screenshot writer passes every row it reads back from the panel to
+ * the atlas as well, which averages boxes of 4 x 4 pixels into a
+ * thumbnail of 60 x 80 pixels on the fly, without a second pass.
+ *
+ * All thumbnails are kept in one file, one slot per activity:
+ *
+ * File       /thumbs.bin: "THMB", version, width, height, number of
+ *            slots, hash of the table, bitmap of the valid slots, then
+ *            the slots of 60 x 80 RGB565 pixels, byte swapped as the
+ *            panel expects
+ *
+ * The slots are the numbers of the activities. setTable() gives the
+ * hash of their names, an atlas made for another table of activities
+ * is not shown and started anew with the next thumbnail.
+ *
+ * open() loads the slots with one sequential read into PSRAM when
+ * there is enough. Without, the slots are read one at a time into a
+ * small cache in the frame arena when row() asks for them.
+ *
+ * Usage    thumbAtlas.request(11);                 // before the screenshot
+ *          saveBmpToSD_16bit(lcd, path);           // calls begin, addRow, finish
+ *
+ *          thumbAtlas.open();
+ *          const uint16_t *pixels = thumbAtlas.row(11, y);
+ *          thumbAtlas.close();
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <SD.h>
+#include "Arena.h"
+
+class ThumbAtlas
+{
+    public:
+        static constexpr int W = 60;
+        static constexpr int H = 80;
+        static constexpr int SCALE = 4;                     // of a 240 x 320 screen
+        static constexpr int PIXELS = W * H;
+        static constexpr uint32_t SLOT_SIZE = 2 * PIXELS;
+        static constexpr int MAX_SLOTS = 128;
+        static constexpr int CACHE_SLOTS = 4;               // without PSRAM
+
+        void setTable(uint32_t hash) { _table = hash; }
+
+        // Producing, from the screenshot writer
+        void request(int slot) { _request = slot; }
+        bool begin(int width, int height);
+        void addRow(const uint16_t *row, int y);
+        bool finish();
+
+        // Reading, for the menu
+        bool open();
+        const uint16_t *row(int slot, int y);
+        void close();
+
+    private:
+        struct Header
+        {
+            uint32_t magic;
+            uint16_t version;
+            uint8_t  w, h;
+            uint16_t slots;
+            uint16_t reserved;
+            uint32_t table;             // hash of the activities the slots belong to
+            uint32_t valid[MAX_SLOTS / 32];
+        };
+
+        bool readHeader(File &f);
+        bool valid(int slot) const { return slot >= 0 && slot < _header.slots && (_header.valid[slot >> 5] & (1u << (slot & 31))); }
+
+        Header    _header = {};
+        uint32_t  _table = 0;
+        int       _request = -1;
+        int       _slot = -1;               // of the thumbnail in the making
+        uint16_t *_pixels = nullptr;        // its pixels, in the frame arena
+        uint16_t  _r[W], _g[W], _b[W];      // sums of the box row
+        int       _sumRow = -1, _rows = 0;
+
+        File      _file;
+        bool      _open = false;
+        uint16_t *_all = nullptr;           // all slots, in PSRAM
+        uint16_t *_cache = nullptr;         // CACHE_SLOTS slots, in the frame arena
+        int       _cached[CACHE_SLOTS];
+        uint32_t  _used[CACHE_SLOTS];
+        uint32_t  _clock = 0;
+        ArenaHold _hold{frameArena};
+};
+
+extern ThumbAtlas thumbAtlas;
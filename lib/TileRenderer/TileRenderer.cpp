@@ -0,0 +1,247 @@
+#include "TileRenderer.h"
+#ifdef ARDUINO
+#include <Arduino.h>
+#define tilePrintf Serial.printf
+#else
+#include <stdio.h>
+#define tilePrintf printf
+#endif
+
+static inline uint16_t swap565(uint16_t c) { return (c >> 8) | (c << 8); }
+
+void TileRenderer::tile(int i, Tile &t) const
+{
+    t.index = i;
+    t.x = (i % _cols) * TILE_SIZE;
+    t.y = (i / _cols) * TILE_SIZE;
+    t.w = _width  - t.x < TILE_SIZE ? _width  - t.x : TILE_SIZE;
+    t.h = _height - t.y < TILE_SIZE ? _height - t.y : TILE_SIZE;
+}
+
+/**
+ * Give each worker a contiguous range of tiles
+*/
+void TileRenderer::reset(int workers)
+{
+    _workers = workers < 1 ? 1 : workers > MAX_WORKERS ? MAX_WORKERS : workers;
+    for (int k = 0; k < _workers; k++)
+    {
+        uint32_t front = tiles() * k / _workers;
+        uint32_t back  = tiles() * (k + 1) / _workers;
+        _range[k].store(front | back << 16);
+        _rendered[k] = 0;
+        _stolen[k] = 0;
+    }
+}
+
+/**
+ * Next tile for a worker: first from its own range, then stolen from the others
+*/
+bool TileRenderer::next(int worker, int &tile)
+{
+    if (take(worker, worker, tile, false)) return true;
+    for (int i = 1; i < _workers; i++)
+        if (take((worker + i) % _workers, worker, tile, true)) return true;
+    return false;
+}
+
+bool TileRenderer::take(int owner, int worker, int &tile, bool fromBack)
+{
+    uint32_t r = _range[owner].load();
+    while (true)
+    {
+        uint32_t front = r & 0xFFFF, back = r >> 16;
+        if (front >= back) return false;
+        uint32_t n = fromBack ? front | (back - 1) << 16 : (front + 1) | back << 16;
+        if (_range[owner].compare_exchange_weak(r, n))
+        {
+            tile = fromBack ? back - 1 : front;
+            _rendered[worker]++;
+            if (fromBack) _stolen[worker]++;
+            return true;
+        }
+    }
+}
+
+void TileRenderer::printStats() const
+{
+    tilePrintf("%d tiles:", tiles());
+    for (int k = 0; k < _workers; k++)
+        tilePrintf(" worker %d %d (%d stolen)", k, _rendered[k], _stolen[k]);
+    tilePrintf("\n");
+}
+
+
+/**
+ * Sort the commands into the tiles covered by their bounding box.
+ * Counting sort in two passes, first count the commands per tile,
+ * then fill in the indices.
+*/
+bool CommandSource::bin(const DrawCmd *cmd, int count)
+{
+    const int n = _renderer.tiles(), cols = _renderer.cols(), rows = _renderer.rows();
+    _cmd = cmd;
+    for (int i = 0; i <= n; i++) _first[i] = 0;
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            const int16_t *a = cmd[i].arg;
+            int x0, y0, x1, y1;
+            switch (cmd[i].op)
+            {
+                case OP_PIXEL:      x0 = x1 = a[0]; y0 = y1 = a[1]; break;
+                case OP_LINE:       x0 = a[0] < a[2] ? a[0] : a[2]; x1 = a[0] + a[2] - x0;
+                                    y0 = a[1] < a[3] ? a[1] : a[3]; y1 = a[1] + a[3] - y0; break;
+                case OP_HLINE:      x0 = a[0]; x1 = a[0] + a[2] - 1; y0 = y1 = a[1]; break;
+                case OP_VLINE:      x0 = x1 = a[0]; y0 = a[1]; y1 = a[1] + a[2] - 1; break;
+                case OP_FILLRECT:   x0 = a[0]; y0 = a[1]; x1 = a[0] + a[2] - 1; y1 = a[1] + a[3] - 1; break;
+                case OP_FILLCIRCLE: x0 = a[0] - a[2]; x1 = a[0] + a[2]; y0 = a[1] - a[2]; y1 = a[1] + a[2]; break;
+                case OP_SCREEN:     x0 = 0; y0 = 0; x1 = cols * TILE_SIZE - 1; y1 = rows * TILE_SIZE - 1; break;
+                default: continue;
+            }
+            if (x1 < x0 || y1 < y0) continue;
+            int tx0 = x0 < 0 ? 0 : x0 / TILE_SIZE, tx1 = x1 / TILE_SIZE;
+            int ty0 = y0 < 0 ? 0 : y0 / TILE_SIZE, ty1 = y1 / TILE_SIZE;
+            if (x1 < 0 || y1 < 0 || tx0 >= cols || ty0 >= rows) continue;
+            if (tx1 >= cols) tx1 = cols - 1;
+            if (ty1 >= rows) ty1 = rows - 1;
+
+            for (int ty = ty0; ty <= ty1; ty++)
+                for (int tx = tx0; tx <= tx1; tx++)
+                {
+                    int t = ty * cols + tx;
+                    if (pass == 0) _first[t + 1]++;
+                    else _index[_first[t]++] = i;
+                }
+        }
+
+        if (pass == 0)
+        {
+            for (int t = 0; t < n; t++) _first[t + 1] += _first[t];
+            if (_first[n] > _capacity)
+            {
+                tilePrintf("CommandSource: %d tile entries, capacity %d\n", _first[n], _capacity);
+                for (int t = 0; t <= n; t++) _first[t] = 0;
+                return false;
+            }
+        }
+    }
+    // the fill pass moved each start to the start of the next tile
+    for (int t = n; t > 0; t--) _first[t] = _first[t - 1];
+    _first[0] = 0;
+    return true;
+}
+
+void CommandSource::render(Tile &t)
+{
+    const uint16_t bg = swap565(_background);
+    for (int i = 0; i < t.w * t.h; i++) t.pixels[i] = bg;
+    if (_cmd == nullptr) return;
+    for (int i = _first[t.index]; i < _first[t.index + 1]; i++)
+        rasterize(t, _cmd[_index[i]]);
+}
+
+static void fillSpan(Tile &t, int x0, int x1, int y, uint16_t c)
+{
+    y -= t.y;
+    if (y < 0 || y >= t.h) return;
+    x0 -= t.x;
+    x1 -= t.x;
+    if (x0 < 0) x0 = 0;
+    if (x1 >= t.w) x1 = t.w - 1;
+    uint16_t *p = t.pixels + y * t.w;
+    for (int x = x0; x <= x1; x++) p[x] = c;
+}
+
+static int isqrt(int n)
+{
+    int r = 0;
+    for (int b = 1 << 14; b > 0; b >>= 1)
+        if ((r + b) * (r + b) <= n) r += b;
+    return r;
+}
+
+/**
+ * Rasterize one command clipped to the tile
+*/
+void CommandSource::rasterize(Tile &t, const DrawCmd &c)
+{
+    const int16_t *a = c.arg;
+    const uint16_t color = swap565(c.color);
+    switch (c.op)
+    {
+        case OP_PIXEL:    fillSpan(t, a[0], a[0], a[1], color); break;
+        case OP_HLINE:    fillSpan(t, a[0], a[0] + a[2] - 1, a[1], color); break;
+        case OP_VLINE:    for (int y = a[1]; y < a[1] + a[2]; y++) fillSpan(t, a[0], a[0], y, color); break;
+        case OP_FILLRECT: for (int y = a[1]; y < a[1] + a[3]; y++) fillSpan(t, a[0], a[0] + a[2] - 1, y, color); break;
+        case OP_SCREEN:   for (int i = 0; i < t.w * t.h; i++) t.pixels[i] = color; break;
+        case OP_FILLCIRCLE:
+            for (int dy = -a[2]; dy <= a[2]; dy++)
+            {
+                int hw = isqrt(a[2] * a[2] - dy * dy + a[2]);
+                fillSpan(t, a[0] - hw, a[0] + hw, a[1] + dy, color);
+            }
+            break;
+        case OP_LINE:
+        {
+            int x0 = a[0], y0 = a[1], x1 = a[2], y1 = a[3];
+            int dx = x1 > x0 ? x1 - x0 : x0 - x1, sx = x0 < x1 ? 1 : -1;
+            int dy = y1 > y0 ? y0 - y1 : y1 - y0, sy = y0 < y1 ? 1 : -1;
+            int err = dx + dy;
+            while (true)
+            {
+                fillSpan(t, x0, x0, y0, color);
+                if (x0 == x1 && y0 == y1) break;
+                int e2 = 2 * err;
+                if (e2 >= dy) { err += dy; x0 += sx; }
+                if (e2 <= dx) { err += dx; y0 += sy; }
+            }
+            break;
+        }
+        default: break;
+    }
+}
+
+
+PointMap::PointMap(uint32_t *buf, int width, int height, const uint16_t palette[4]) : 
+    _map(buf), _width(width), _height(height)
+{
+    for (int i = 0; i < 4; i++) _palette[i] = swap565(palette[i]);
+}
+
+void PointMap::clear()
+{
+    for (int i = 0; i < words(_width, _height); i++) _map[i] = 0;
+}
+
+/**
+ * Set the color index of a point. The 16 points of a word can be 
+ * plotted by different workers, so the word is replaced with 
+ * compare and swap.
+*/
+void PointMap::plot(int x, int y, uint8_t index)
+{
+    if (x < 0 || y < 0 || x >= _width || y >= _height) return;
+    uint32_t bit = 2 * (y * _width + x);
+    uint32_t *word = _map + (bit >> 5);
+    uint32_t shift = bit & 31;
+    uint32_t old = __atomic_load_n(word, __ATOMIC_RELAXED), n;
+    do
+    {
+        n = (old & ~(3u << shift)) | (uint32_t)(index & 3) << shift;
+        if (n == old) return;
+    } while (!__atomic_compare_exchange_n(word, &old, n, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+void PointMap::render(Tile &t)
+{
+    uint16_t *p = t.pixels;
+    for (int y = t.y; y < t.y + t.h; y++)
+    {
+        uint32_t bit = 2 * (y * _width + t.x);
+        for (int x = 0; x < t.w; x++, bit += 2)
+            *p++ = _palette[(_map[bit >> 5] >> (bit & 31)) & 3];
+    }
+}
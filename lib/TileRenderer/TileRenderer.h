@@ -0,0 +1,154 @@
+/**
+ * Tile renderer
+ * 
+ * Splits the screen into tiles of 32 x 32 pixels, which are rendered 
+ * in parallel by a pool of workers into small tile buffers. A single 
+ * flush stage sends the finished tiles to the lcd with DMA while the 
+ * workers continue with the next tiles.
+ * 
+ * The tiles are distributed to the workers by work stealing: each 
+ * worker owns a contiguous range of tiles and takes them from its 
+ * front. A worker whose range is empty steals from the back of the 
+ * range of another worker.
+ * 
+ * What is rendered into a tile is defined by a TileSource:
+ *  - ShaderSource     calls a function computing all pixels of a tile (Mandelbrot, gradients)
+ *  - CommandSource    rasterizes draw commands binned per tile (display lists)
+ *  - PointMap         colors the points plotted by iterated function systems (IFS)
+ * All sources must be thread safe, render() runs on several workers at once.
+ * 
+ * On the ESP32 there are 2 workers, one on each core. On the host 
+ * (no ARDUINO defined) the pool uses std::thread with any number 
+ * of threads, which allows scaling benchmarks (see bench/tileBench.cpp).
+*/
+
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "DrawCmd.h"
+
+constexpr int TILE_SIZE = 32;
+
+struct Tile
+{
+    int16_t   index;
+    int16_t   x, y, w, h;
+    uint16_t *pixels;     // w * h byte swapped RGB565 pixels, row by row
+};
+
+class TileSource
+{
+    public:
+        virtual void render(Tile &t) = 0;
+};
+
+class TileSink
+{
+    public:
+        virtual void flush(const Tile &t) = 0;
+};
+
+using WorkerJob = void(*)(int worker, void *ctx);
+
+class TileRenderer
+{
+    public:
+        static constexpr int MAX_WORKERS = 16;
+
+        TileRenderer(int width, int height) : 
+            _width(width), _height(height), 
+            _cols((width + TILE_SIZE - 1) / TILE_SIZE), _rows((height + TILE_SIZE - 1) / TILE_SIZE) {}
+
+        int  tiles() const { return _cols * _rows; }
+        int  cols() const { return _cols; }
+        int  rows() const { return _rows; }
+        void tile(int i, Tile &t) const;
+        void reset(int workers);
+        bool next(int worker, int &tile);
+        void printStats() const;
+
+    private:
+        bool take(int owner, int worker, int &tile, bool fromBack);
+
+        int _width, _height, _cols, _rows;
+        int _workers = 1;
+        std::atomic<uint32_t> _range[MAX_WORKERS];   // front | back << 16 of the tiles owned by each worker
+        uint16_t _rendered[MAX_WORKERS];
+        uint16_t _stolen[MAX_WORKERS];
+};
+
+
+/**
+ * Calls a function that computes all pixels of a tile
+*/
+class ShaderSource : public TileSource
+{
+    public:
+        using Shader = void(*)(Tile &t, void *ctx);
+        ShaderSource(Shader shader, void *ctx = nullptr) : _shader(shader), _ctx(ctx) {}
+        void render(Tile &t) override { _shader(t, _ctx); }
+
+    private:
+        Shader _shader;
+        void  *_ctx;
+};
+
+
+/**
+ * Draw commands sorted into the tiles they touch. Supported are 
+ * pixels, lines, filled rectangles, filled circles and fillScreen, 
+ * the other commands are skipped.
+ * The index buffer needs one entry per tile touched by each command.
+*/
+class CommandSource : public TileSource
+{
+    public:
+        CommandSource(const TileRenderer &r, uint16_t *index, int indexCapacity, uint16_t *first, uint16_t background) : 
+            _renderer(r), _index(index), _capacity(indexCapacity), _first(first), _background(background) {}
+
+        bool bin(const DrawCmd *cmd, int count);
+        void render(Tile &t) override;
+
+    private:
+        void rasterize(Tile &t, const DrawCmd &c);
+
+        const TileRenderer &_renderer;
+        const DrawCmd *_cmd = nullptr;
+        uint16_t *_index;       // command indices, grouped by tile
+        int       _capacity;
+        uint16_t *_first;       // tiles() + 1 entries, start of each group in _index
+        uint16_t  _background;
+};
+
+
+/**
+ * Map with a 2 bit color index per pixel. Points can be plotted 
+ * by several workers at once, index 0 is the background.
+ * The buffer needs (width * height + 15) / 16 words.
+*/
+class PointMap : public TileSource
+{
+    public:
+        PointMap(uint32_t *buf, int width, int height, const uint16_t palette[4]);
+
+        void clear();
+        void plot(int x, int y, uint8_t index);
+        void render(Tile &t) override;
+        static int words(int width, int height) { return (width * height + 15) / 16; }
+
+    private:
+        uint32_t *_map;
+        int       _width, _height;
+        uint16_t  _palette[4];  // byte swapped
+};
+
+
+#ifdef ARDUINO
+class LGFX;
+void renderTiles(LGFX &lcd, TileRenderer &r, TileSource &src);
+void runOnWorkers(WorkerJob job, void *ctx);
+constexpr int nbrTileWorkers = 2;
+#else
+void renderTiles(int threads, TileRenderer &r, TileSource &src, TileSink &sink);
+void runOnWorkers(int threads, WorkerJob job, void *ctx);
+#endif
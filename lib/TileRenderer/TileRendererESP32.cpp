@@ -0,0 +1,146 @@
+/**
+ * Worker pool on the ESP32: one worker task pinned to each core.
+ * The calling task is the flush stage, it sends the finished tiles 
+ * to the lcd with DMA.
+*/
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "TileRenderer.h"
+#include "RenderStats.h"
+#include "MemTelemetry.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+constexpr int NBR_TILE_BUFFERS = 4;
+constexpr int WORKER_PRIORITY = 2;
+constexpr int FLUSH_PRIORITY = 3;    // above the workers, so a finished tile is sent at once
+
+struct FinishedTile
+{
+    int16_t tile;
+    int16_t buffer;
+};
+
+static TaskHandle_t workerTask[nbrTileWorkers];
+static SemaphoreHandle_t startSemaphore[nbrTileWorkers];
+static SemaphoreHandle_t doneSemaphore;
+static QueueHandle_t freeBuffers, finishedTiles;
+static WorkerJob workerJob;
+static void *workerCtx;
+alignas(4) static uint16_t tileBuffer[NBR_TILE_BUFFERS][TILE_SIZE * TILE_SIZE];
+
+static void workerLoop(void *param)
+{
+    const int worker = (int)(intptr_t)param;
+    while (true)
+    {
+        xSemaphoreTake(startSemaphore[worker], portMAX_DELAY);
+        workerJob(worker, workerCtx);
+        xSemaphoreGive(doneSemaphore);
+    }
+}
+
+/**
+ * Create the worker tasks and queues on first use
+*/
+static void startWorkers()
+{
+    if (doneSemaphore != nullptr) return;
+    doneSemaphore = xSemaphoreCreateCounting(nbrTileWorkers, 0);
+    freeBuffers = xQueueCreate(NBR_TILE_BUFFERS, sizeof(int16_t));
+    finishedTiles = xQueueCreate(NBR_TILE_BUFFERS, sizeof(FinishedTile));
+    for (int16_t b = 0; b < NBR_TILE_BUFFERS; b++) xQueueSend(freeBuffers, &b, 0);
+    for (int k = 0; k < nbrTileWorkers; k++)
+    {
+        startSemaphore[k] = xSemaphoreCreateBinary();
+        xTaskCreatePinnedToCore(workerLoop, "tileWorker", 3072, (void*)(intptr_t)k, WORKER_PRIORITY, &workerTask[k], k);
+        memTelemetry.watch(workerTask[k], k == 0 ? "tileWorker0" : "tileWorker1");
+    }
+    log_i("%d tile workers, %d tile buffers", nbrTileWorkers, NBR_TILE_BUFFERS);
+}
+
+static void beginJob(WorkerJob job, void *ctx)
+{
+    startWorkers();
+    workerJob = job;
+    workerCtx = ctx;
+    for (int k = 0; k < nbrTileWorkers; k++) xSemaphoreGive(startSemaphore[k]);
+}
+
+static void waitJob()
+{
+    for (int k = 0; k < nbrTileWorkers; k++) xSemaphoreTake(doneSemaphore, portMAX_DELAY);
+}
+
+/**
+ * Run a job on all workers at once and wait until all have finished
+*/
+void runOnWorkers(WorkerJob job, void *ctx)
+{
+    beginJob(job, ctx);
+    waitJob();
+}
+
+struct TileJob
+{
+    TileRenderer &renderer;
+    TileSource   &source;
+};
+
+static void renderJob(int worker, void *ctx)
+{
+    TileJob &job = *(TileJob*)ctx;
+    int i;
+    while (job.renderer.next(worker, i))
+    {
+        FinishedTile f;
+        f.tile = i;
+        xQueueReceive(freeBuffers, &f.buffer, portMAX_DELAY);
+        Tile t;
+        job.renderer.tile(i, t);
+        t.pixels = tileBuffer[f.buffer];
+        job.source.render(t);
+        xQueueSend(finishedTiles, &f, portMAX_DELAY);
+    }
+}
+
+/**
+ * Render all tiles with the workers and flush them as they are finished.
+ * A tile buffer is returned to the workers when the transfer of the 
+ * next tile has started, pushImageDMA waits for the previous transfer.
+*/
+void renderTiles(LGFX &lcd, TileRenderer &r, TileSource &src)
+{
+    TileJob job = { r, src };
+    r.reset(nbrTileWorkers);
+
+    UBaseType_t priority = uxTaskPriorityGet(NULL);
+    vTaskPrioritySet(NULL, FLUSH_PRIORITY);
+    beginJob(renderJob, &job);
+
+    lcd.startWrite();
+    int16_t inFlight = -1;
+    for (int n = 0; n < r.tiles(); n++)
+    {
+        FinishedTile f;
+        xQueueReceive(finishedTiles, &f, portMAX_DELAY);
+        Tile t;
+        r.tile(f.tile, t);
+        lcd.pushImageDMA(t.x, t.y, t.w, t.h, (lgfx::swap565_t*)tileBuffer[f.buffer]);
+        renderCounters.addPush(2 * t.w * t.h);
+        if (inFlight >= 0) xQueueSend(freeBuffers, &inFlight, 0);
+        inFlight = f.buffer;
+    }
+    lcd.waitDMA();
+    lcd.endWrite();
+    if (inFlight >= 0) xQueueSend(freeBuffers, &inFlight, 0);
+
+    waitJob();
+    vTaskPrioritySet(NULL, priority);
+}
+#endif
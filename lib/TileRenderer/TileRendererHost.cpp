@@ -0,0 +1,83 @@
+/**
+ * Worker pool on the host with std::thread, used for scaling benchmarks.
+ * The calling thread is the flush stage and passes the finished tiles 
+ * to a TileSink.
+*/
+
+#ifndef ARDUINO
+#include "TileRenderer.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <deque>
+
+void runOnWorkers(int threads, WorkerJob job, void *ctx)
+{
+    std::vector<std::thread> pool;
+    for (int k = 0; k < threads; k++) pool.emplace_back(job, k, ctx);
+    for (auto &t : pool) t.join();
+}
+
+template<class T> class BlockingQueue
+{
+    public:
+        void push(const T &v)
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(v);
+            _ready.notify_one();
+        }
+
+        T pop()
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _ready.wait(lock, [this] { return !_queue.empty(); });
+            T v = _queue.front();
+            _queue.pop_front();
+            return v;
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _ready;
+        std::deque<T> _queue;
+};
+
+/**
+ * Same structure as on the ESP32: the workers render into a fixed set 
+ * of tile buffers, the caller flushes and returns the buffers.
+*/
+void renderTiles(int threads, TileRenderer &r, TileSource &src, TileSink &sink)
+{
+    const int nbrBuffers = 2 * threads;
+    std::vector<uint16_t> buffers(nbrBuffers * TILE_SIZE * TILE_SIZE);
+    BlockingQueue<int> freeBuffers;
+    BlockingQueue<Tile> finishedTiles;
+    for (int b = 0; b < nbrBuffers; b++) freeBuffers.push(b);
+    r.reset(threads);
+
+    std::vector<std::thread> pool;
+    for (int k = 0; k < threads; k++)
+        pool.emplace_back([&, k]
+        {
+            int i;
+            while (r.next(k, i))
+            {
+                Tile t;
+                r.tile(i, t);
+                t.pixels = &buffers[freeBuffers.pop() * TILE_SIZE * TILE_SIZE];
+                src.render(t);
+                finishedTiles.push(t);
+            }
+        });
+
+    for (int n = 0; n < r.tiles(); n++)
+    {
+        Tile t = finishedTiles.pop();
+        sink.flush(t);
+        freeBuffers.push((t.pixels - buffers.data()) / (TILE_SIZE * TILE_SIZE));
+    }
+    for (auto &t : pool) t.join();
+}
+#endif
@@ -1,4 +1,12 @@
 #include "Turtle.h"
+#include "LineRaster.h"
+#include "AALines.h"
+
+Turtle::~Turtle()
+{
+    delete _aa;
+}
+
 
 void Turtle::clear()
 {
@@ -22,7 +30,8 @@ void Turtle::forward(float step)
     _x += round(step * cos(h));
     _y += round(step * sin(h));
     //log_i("_x=%3d, _y=%3d\n", _x, _y);
-    if (_penDown) _lcd.drawLine(x, y, _x, _y, _penColor);
+    if (_penDown) line(x, y, _x, _y);
+    else _recordGap = true;
 }
 
 
@@ -58,35 +67,68 @@ void Turtle::penUp()
     _penDown = false;
 }
 
+/**
+ * Line with the integer Bresenham algorithm, clipped to the lcd
+*/
 void Turtle::bresenham(int x0, int y0, int x1, int y1)
 {
-    int dx =  abs(x1 - x0), sx = x0 < x1 ? 1 : -1;
-    int dy = -abs(y1 - y0), sy = y0 < y1 ? 1 : -1;
-    int err = dx + dy, e2; /* error value e_xy */
-
-    while (true) 
-    {
-        _lcd.drawPixel(x0, y0, _penColor);
-        if (x0 == x1 && y0 == y1) break;
-        e2 = 2 * err;
-        if (e2 > dy) { err += dy; x0 += sx; } /* e_xy+e_x > 0 */
-        if (e2 < dx) { err += dx; y0 += sy; } /* e_xy+e_y < 0 */
-    }
+    drawClippedLine(_lcd, x0, y0, x1, y1, _penColor);
 }
 
 void Turtle::moveTo(int x, int y)
 {
     if (_penDown)
     {
-        //Bresenham(_x, _y, x, y);
-        _lcd.drawLine(_x, _y, x, y, _penColor);
+        line(_x, _y, x, y);
         _x = x; _y = y;          
     }
     else
     {
         _x = x;
         _y = y;
+        _recordGap = true;
+    }
+}
+
+
+/**
+ * Record the following lines into the polyline p instead of drawing 
+ * them, p = nullptr ends the recording
+*/
+void Turtle::record(Polyline *p)
+{
+    _record = p;
+    _recordGap = true;
+}
+
+
+/**
+ * The anti-aliased lines in pen and screen color when the mode is 
+ * on (AALines::enabled), else nullptr
+*/
+AALines *Turtle::antiAliasing()
+{
+    if (! AALines::enabled) return nullptr;
+    if (_aa && (_aa->pen() != _penColor || _aa->background() != _screenColor))
+    {
+        delete _aa;
+        _aa = nullptr;
+    }
+    if (_aa == nullptr) _aa = new AALines(_lcd, _penColor, _screenColor);
+    return _aa;
+}
+
+
+void Turtle::line(int x0, int y0, int x1, int y1)
+{
+    if (_record == nullptr)
+    {
+        bresenham(x0, y0, x1, y1);
+        return;
     }
+    if (_recordGap) _record->moveTo(x0, y0);
+    _record->add(x1, y1);
+    _recordGap = false;
 }
 
 void Turtle::penColor(int color)
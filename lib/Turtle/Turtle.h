@@ -3,12 +3,16 @@
  * 
  * Turtle origin (0,0) is at upper left corne of the lcd
  * Turtle heading 0.0 degrees is to the right in positive x direction
+ * Lines are clipped to the lcd, the turtle may walk outside of it
 */
 
 #pragma once
 #include <Arduino.h>
 #include <LovyanGFX.hpp>
 #include "lgfx_ESP32_2432S028.h"
+#include "Polyline.h"
+
+class AALines;
 
 class Turtle
 {
@@ -18,6 +22,9 @@ class Turtle
         Turtle(LGFX &lcd, int x0, int y0, float heading, int penColor=TFT_WHITE) : 
             _lcd(lcd), _x(x0), _y(y0), _heading(heading), _penColor(penColor)
         { lcd.fillScreen(_screenColor); }
+        ~Turtle();
+        Turtle(const Turtle&) = delete;
+        Turtle &operator=(const Turtle&) = delete;
 
         LGFX  &_lcd;
         void clear();
@@ -33,12 +40,24 @@ class Turtle
         void screenColor(int color);
         void showValues();
         void bresenham(int x, int y, int x1, int y1);
+        void record(Polyline *p);
+        AALines *antiAliasing();
+
+        int   x() const { return _x; }
+        int   y() const { return _y; }
+        float heading() const { return _heading; }
+        int   penColor() const { return _penColor; }
 
     private:
+        void line(int x0, int y0, int x1, int y1);
+
         float _heading; // heading in degrees
         int   _x;       // x position on screen
         int   _y;       // y position on screen 
         int   _penColor;
         int   _screenColor = TFT_BLACK;
         bool  _penDown = true;  
+        Polyline *_record = nullptr;  // lines go into this polyline instead of to the lcd
+        bool  _recordGap = true;      // the next recorded line starts a new polyline
+        AALines *_aa = nullptr;       // anti-aliased lines of this turtle in pen and screen color
 };
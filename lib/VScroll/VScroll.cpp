@@ -0,0 +1,138 @@
+#include "VScroll.h"
+#include "RenderStats.h"
+#include "Arena.h"
+
+constexpr uint8_t ILI9341_NORON    = 0x13;  // normal display mode, ends the scroll mode
+constexpr uint8_t ILI9341_VSCRDEF  = 0x33;  // vertical scrolling definition
+constexpr uint8_t ILI9341_VSCRSADD = 0x37;  // vertical scrolling start address
+
+static void writeData16(LGFX &lcd, uint16_t d)
+{
+    lcd.writedata(d >> 8);
+    lcd.writedata(d & 0xFF);
+}
+
+
+/**
+ * Define a scroll area between top fixed rows at the top and bottom
+ * fixed rows at the bottom of the screen and fill it with the content
+ * rows 0 .. height()-1. The two line buffers are taken from the frame
+ * arena until end(). Fails when the lcd is not in portrait orientation
+ * or the arena is full.
+*/
+bool VScroll::begin(int top, int bottom, RowFn row, void *ctx)
+{
+    if (_lcd.height() != LINES || _lcd.width() > MAX_WIDTH)
+    {
+        log_e("hardware scrolling needs a portrait orientation");
+        return false;
+    }
+    if (top < 0 || bottom < 0 || top + bottom >= LINES) return false;
+    _hold.take();
+    _line = frameArena.alloc<uint16_t>(2 * _lcd.width());
+    if (_line == nullptr)
+    {
+        log_e("No memory for the scroll lines");
+        _hold.release();
+        return false;
+    }
+    _top = top;
+    _bottom = bottom;
+    _h = LINES - top - bottom;
+    _row = row;
+    _ctx = ctx;
+    _offset = 0;
+
+    _lcd.waitDMA();
+    _lcd.writecommand(ILI9341_VSCRDEF);
+    writeData16(_lcd, _mirrored ? bottom : top);
+    writeData16(_lcd, _h);
+    writeData16(_lcd, _mirrored ? top : bottom);
+    _active = true;
+    setStart();
+    render(0, _h);
+    return true;
+}
+
+
+/**
+ * Show the memory in its own order again. The content stays where it
+ * was written, so the screen needs to be drawn anew, with keep the 
+ * visible rows are rendered once more at their places.
+*/
+void VScroll::end(bool keep)
+{
+    if (! _active) return;
+    _lcd.waitDMA();
+    _lcd.writecommand(ILI9341_VSCRSADD);
+    writeData16(_lcd, 0);
+    _lcd.writecommand(ILI9341_NORON);
+    _active = false;
+    if (keep) render(_offset, _offset + _h);
+    _hold.release();
+    _line = nullptr;
+}
+
+
+/**
+ * Scroll so that content row offset is at the top of the scroll area.
+ * Only the rows that come into view are rendered, all of them when
+ * the move is larger than the area.
+*/
+void VScroll::scrollTo(int offset)
+{
+    if (! _active || offset == _offset) return;
+    int from, to;
+    if (abs(offset - _offset) >= _h) { from = offset;      to = offset + _h; }
+    else if (offset > _offset)       { from = _offset + _h; to = offset + _h; }
+    else                             { from = offset;      to = _offset; }
+    _offset = offset;
+    render(from, to);
+    setStart();
+}
+
+
+/**
+ * Render the content rows from .. to-1 again, as far as they are visible
+*/
+void VScroll::refresh(int from, int to)
+{
+    if (! _active) return;
+    if (from < _offset) from = _offset;
+    if (to > _offset + _h) to = _offset + _h;
+    render(from, to);
+}
+
+
+/**
+ * Render the content rows from .. to-1 into their memory lines, one
+ * line buffer is sent while the other one is filled
+*/
+void VScroll::render(int from, int to)
+{
+    if (from >= to) return;
+    const int w = _lcd.width();
+    _lcd.startWrite();
+    for (int c = from; c < to; c++)
+    {
+        uint16_t *buf = _line + _current * w;
+        _row(c, buf, w, _ctx);
+        _lcd.pushImageDMA(0, line(c), w, 1, (lgfx::swap565_t*)buf);
+        renderCounters.addPush(2 * w);
+        _current ^= 1;
+    }
+    _lcd.waitDMA();
+    _lcd.endWrite();
+}
+
+
+/**
+ * Tell the panel which memory line is shown at the top of the scroll area
+*/
+void VScroll::setStart()
+{
+    int start = _mirrored ? _bottom + mod(-_offset, _h) : _top + mod(_offset, _h);
+    _lcd.waitDMA();
+    _lcd.writecommand(ILI9341_VSCRSADD);
+    writeData16(_lcd, start);
+}
@@ -0,0 +1,74 @@
+/**
+ * Hardware vertical scrolling of the ILI9341
+ *
+ * The ILI9341 can show its frame memory starting at any line: the
+ * scroll area between a fixed top and bottom area is defined once with
+ * VSCRDEF (0x33) and VSCRSADD (0x37) selects the line of the memory
+ * shown at the top of the scroll area. Scrolling by d rows therefore
+ * costs one command and the d rows that come into view, instead of
+ * sending the whole screen again.
+ *
+ * The content is a virtual list of rows, row c is kept in the memory
+ * line top + c mod h (h the height of the scroll area). scrollTo()
+ * calls the row function for the rows exposed by the move only, each
+ * row is sent with DMA from one of two line buffers in the frame arena
+ * while the next one is rendered, then the start line is set. refresh() renders a range
+ * of visible rows again, e.g. a tile whose look changed.
+ *
+ * end(true) leaves the scroll mode with the visible rows rendered
+ * again in their own order, so the last view stays on the screen (and
+ * in a screenshot read back from the panel).
+ *
+ * The scroll direction of the panel follows its memory lines, so the
+ * lcd must be in a portrait orientation. With the line order of the
+ * panel mirrored set mirrored, the fixed areas are swapped and the
+ * start line is counted from the other end.
+ *
+ * Usage    VScroll vs(lcd);
+ *          vs.begin(24, 0, contentRow, &ctx);      // title bar of 24 rows
+ *          vs.scrollTo(120);
+ *          vs.end();                               // back to the normal mode
+*/
+
+#pragma once
+#include <Arduino.h>
+#include <LovyanGFX.hpp>
+#include "lgfx_ESP32_2432S028.h"
+#include "Arena.h"
+
+class VScroll
+{
+    public:
+        static constexpr int MAX_WIDTH = 240;      // smaller dimension of the display
+        static constexpr int LINES = 320;          // memory lines of the ILI9341
+
+        // Renders the content row c as width byte swapped pixels into line
+        using RowFn = void (*)(int c, uint16_t *line, int width, void *ctx);
+
+        VScroll(LGFX &lcd, bool mirrored = false) : _lcd(lcd), _mirrored(mirrored) {}
+
+        bool begin(int top, int bottom, RowFn row, void *ctx);
+        void end(bool keep = false);
+        void scrollTo(int offset);
+        void refresh(int from, int to);
+        int  offset() const { return _offset; }
+        int  height() const { return _h; }
+        int  top() const { return _top; }
+
+    private:
+        void render(int from, int to);
+        int  line(int c) const { return _top + (_active ? mod(c, _h) : c - _offset); }
+        void setStart();
+        static int mod(int a, int n) { int r = a % n; return r < 0 ? r + n : r; }
+
+        LGFX &_lcd;
+        bool  _mirrored;
+        bool  _active = false;
+        int   _top = 0, _bottom = 0, _h = LINES;
+        int   _offset = 0;
+        int   _current = 0;
+        RowFn _row = nullptr;
+        void *_ctx = nullptr;
+        uint16_t *_line = nullptr;          // two line buffers, in the frame arena
+        ArenaHold _hold{frameArena};
+};
@@ -8,8 +8,26 @@
  *            The file is required to use the graphical library LovyanGFX
  *  
  * Reference  https://github.com/lovyan03/LovyanGFX/blob/master/examples/HowToUse/2_user_setting
+ * 
+ * Profiling  Build with -D LGFX_PROFILE to replace the draw calls by 
+ *            instrumented versions (see DrawProfiler.h)
+ * 
+ * Tracing    Build with -D LGFX_TRACE to be able to record the draw 
+ *            calls to a trace file (see DrawTrace.h)
 */
 #pragma once
+#ifdef LGFX_PROFILE
+#include "DrawProfiler.h"
+#define LGFX_PROBE(...) DrawProbe probe(__VA_ARGS__)
+#else
+#define LGFX_PROBE(...)
+#endif
+#ifdef LGFX_TRACE
+#include "DrawTrace.h"
+#define LGFX_RECORD(op, c, ...) do { if (drawTrace.isRecording()) drawTrace.record(op, DrawTrace::color(c), {__VA_ARGS__}); } while (0)
+#else
+#define LGFX_RECORD(op, c, ...)
+#endif
 
 class LGFX : public lgfx::LGFX_Device {
   lgfx::Panel_ILI9341 _panel_instance;
@@ -89,4 +107,109 @@ public:
     
     setPanel(&_panel_instance);  // set the panel to be used.
   }
+
+#if defined(LGFX_PROFILE) || defined(LGFX_TRACE)
+  // Instrumented draw calls, they hide those of LGFX_Device
+  using Base = lgfx::LGFX_Device;
+#ifdef LGFX_PROFILE
+  using P    = DrawProfiler;
+#endif
+
+  template<typename T> void drawPixel(int32_t x, int32_t y, const T &c)
+  { LGFX_PROBE(PRIM_PIXEL, 1); LGFX_RECORD(OP_PIXEL, c, x, y); Base::drawPixel(x, y, c); }
+  template<typename T> void writePixel(int32_t x, int32_t y, const T &c)
+  { LGFX_PROBE(PRIM_PIXEL, 1); LGFX_RECORD(OP_PIXEL, c, x, y); Base::writePixel(x, y, c); }
+  template<typename T> void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, const T &c)
+  { 
+    LGFX_PROBE(PRIM_LINE, P::linePixels(x0, y0, x1, y1), P::lineWindows(x0, y0, x1, y1)); 
+    LGFX_RECORD(OP_LINE, c, x0, y0, x1, y1);
+    Base::drawLine(x0, y0, x1, y1, c); 
+  }
+  template<typename T> void drawFastHLine(int32_t x, int32_t y, int32_t w, const T &c)
+  { LGFX_PROBE(PRIM_HLINE, abs(w)); LGFX_RECORD(OP_HLINE, c, x, y, w); Base::drawFastHLine(x, y, w, c); }
+  template<typename T> void writeFastHLine(int32_t x, int32_t y, int32_t w, const T &c)
+  { LGFX_PROBE(PRIM_HLINE, abs(w)); LGFX_RECORD(OP_HLINE, c, x, y, w); Base::writeFastHLine(x, y, w, c); }
+  template<typename T> void drawFastVLine(int32_t x, int32_t y, int32_t h, const T &c)
+  { LGFX_PROBE(PRIM_VLINE, abs(h)); LGFX_RECORD(OP_VLINE, c, x, y, h); Base::drawFastVLine(x, y, h, c); }
+  template<typename T> void writeFastVLine(int32_t x, int32_t y, int32_t h, const T &c)
+  { LGFX_PROBE(PRIM_VLINE, abs(h)); LGFX_RECORD(OP_VLINE, c, x, y, h); Base::writeFastVLine(x, y, h, c); }
+  template<typename T> void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, const T &c)
+  { LGFX_PROBE(PRIM_RECT, 2 * (abs(w) + abs(h)), 4); LGFX_RECORD(OP_RECT, c, x, y, w, h); Base::drawRect(x, y, w, h, c); }
+  template<typename T> void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, const T &c)
+  { LGFX_PROBE(PRIM_FILLRECT, abs(w * h)); LGFX_RECORD(OP_FILLRECT, c, x, y, w, h); Base::fillRect(x, y, w, h, c); }
+  template<typename T> void writeFillRect(int32_t x, int32_t y, int32_t w, int32_t h, const T &c)
+  { LGFX_PROBE(PRIM_FILLRECT, abs(w * h)); LGFX_RECORD(OP_FILLRECT, c, x, y, w, h); Base::writeFillRect(x, y, w, h, c); }
+  template<typename T> void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, const T &c)
+  { 
+    LGFX_PROBE(PRIM_ROUNDRECT, 2 * (abs(w) + abs(h)), 4 + 4 * r); 
+    LGFX_RECORD(OP_ROUNDRECT, c, x, y, w, h, r); 
+    Base::drawRoundRect(x, y, w, h, r, c); 
+  }
+  template<typename T> void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, const T &c)
+  { 
+    LGFX_PROBE(PRIM_ROUNDRECT, abs(w * h), 1 + 4 * r); 
+    LGFX_RECORD(OP_FILLROUNDRECT, c, x, y, w, h, r); 
+    Base::fillRoundRect(x, y, w, h, r, c); 
+  }
+  template<typename T> void drawCircle(int32_t x, int32_t y, int32_t r, const T &c)
+  { LGFX_PROBE(PRIM_CIRCLE, 6 * r + 4, 6 * r + 4); LGFX_RECORD(OP_CIRCLE, c, x, y, r); Base::drawCircle(x, y, r, c); }
+  template<typename T> void fillCircle(int32_t x, int32_t y, int32_t r, const T &c)
+  { 
+    LGFX_PROBE(PRIM_FILLCIRCLE, (201 * r * r >> 6) + 2 * r + 1, 2 * r + 1); 
+    LGFX_RECORD(OP_FILLCIRCLE, c, x, y, r); 
+    Base::fillCircle(x, y, r, c); 
+  }
+  template<typename T> void drawTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const T &c)
+  { 
+    LGFX_PROBE(PRIM_TRIANGLE, P::linePixels(x0, y0, x1, y1) + P::linePixels(x1, y1, x2, y2) + P::linePixels(x2, y2, x0, y0),
+                              P::lineWindows(x0, y0, x1, y1) + P::lineWindows(x1, y1, x2, y2) + P::lineWindows(x2, y2, x0, y0)); 
+    LGFX_RECORD(OP_TRIANGLE, c, x0, y0, x1, y1, x2, y2);
+    Base::drawTriangle(x0, y0, x1, y1, x2, y2, c); 
+  }
+  template<typename T> void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const T &c)
+  { 
+    LGFX_PROBE(PRIM_FILLTRIANGLE, abs((x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0)) / 2, 
+                                  std::max({y0, y1, y2}) - std::min({y0, y1, y2}) + 1); 
+    LGFX_RECORD(OP_FILLTRIANGLE, c, x0, y0, x1, y1, x2, y2);
+    Base::fillTriangle(x0, y0, x1, y1, x2, y2, c); 
+  }
+  template<typename T> void drawGradientHLine(int32_t x, int32_t y, int32_t w, const T &c0, const T &c1)
+  { LGFX_PROBE(PRIM_GRADIENT, abs(w)); Base::drawGradientHLine(x, y, w, c0, c1); }   // not traced
+  template<typename T> void drawGradientVLine(int32_t x, int32_t y, int32_t h, const T &c0, const T &c1)
+  { LGFX_PROBE(PRIM_GRADIENT, abs(h)); Base::drawGradientVLine(x, y, h, c0, c1); }   // not traced
+  template<typename T> void pushImage(int32_t x, int32_t y, int32_t w, int32_t h, const T *data)
+  { 
+    LGFX_PROBE(PRIM_IMAGE, w * h); 
+#ifdef LGFX_TRACE
+    if (drawTrace.isRecording() && sizeof(T) == 2) 
+      drawTrace.recordImage(x, y, w, h, (const uint16_t*)data, DrawTrace::isSwapped(data));
+#endif
+    Base::pushImage(x, y, w, h, data); 
+  }
+  template<typename T> void pushImageDMA(int32_t x, int32_t y, int32_t w, int32_t h, const T *data)
+  { 
+    LGFX_PROBE(PRIM_IMAGE_DMA, w * h);    // measures the start of the transfer only
+#ifdef LGFX_TRACE
+    if (drawTrace.isRecording() && sizeof(T) == 2) 
+      drawTrace.recordImage(x, y, w, h, (const uint16_t*)data, DrawTrace::isSwapped(data));
+#endif
+    Base::pushImageDMA(x, y, w, h, data); 
+  }
+  template<typename T> void readRect(int32_t x, int32_t y, int32_t w, int32_t h, T *data)
+  { LGFX_PROBE(PRIM_READ, w * h, 1, 3); Base::readRect(x, y, w, h, data); }
+  template<typename T> void fillScreen(const T &c)
+  { LGFX_PROBE(PRIM_SCREEN, width() * height()); LGFX_RECORD(OP_SCREEN, c); Base::fillScreen(c); }
+  size_t drawChar(uint16_t ch, int32_t x, int32_t y)
+  { LGFX_PROBE(PRIM_TEXT, fontHeight() * fontHeight() / 2, fontHeight()); LGFX_RECORD(OP_CHAR, 0, ch, x, y); return Base::drawChar(ch, x, y); }
+  size_t drawString(const char *str, int32_t x, int32_t y)
+  { 
+    LGFX_PROBE(PRIM_TEXT, textWidth(str) * fontHeight(), fontHeight()); 
+#ifdef LGFX_TRACE
+    if (drawTrace.isRecording()) drawTrace.recordString(x, y, str);
+#endif
+    return Base::drawString(str, x, y); 
+  }
+  void setRotation(uint_fast8_t r)
+  { LGFX_RECORD(OP_ROTATION, 0, r); Base::setRotation(r); }
+#endif
 };         
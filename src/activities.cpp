@@ -0,0 +1,239 @@
+#include <Arduino.h>
+#include "Activity.h"
+#include "RenderStats.h"
+#include "Hud.h"
+#include "Rng.h"
+#include "MemTelemetry.h"
+#include "Arena.h"
+#include "SdCatalog.h"
+#include "ScrollLog.h"
+
+// Graphical examples defined in graphicPatterns.cpp
+extern void barnsleyFern(LGFX &lcd);
+extern void circles(LGFX &lcd);
+extern void colorTiles(LGFX &lcd);
+extern void colorGradients(LGFX &lcd);
+extern void hsvColorCircle(LGFX &lcd);
+extern void mandelbrot(LGFX &lcd);
+extern void mandelbrotSmooth(LGFX &lcd);
+extern void mandelbrotTiles(LGFX &lcd);
+extern void rainbowStripes(LGFX &lcd);
+extern void randomDots(LGFX &lcd);
+extern void rectangles(LGFX &lcd);
+extern void rgbTiles(LGFX &lcd);
+extern void roundRectangles(LGFX &lcd);
+extern void sierpinskiTriangle(LGFX &lcd);
+extern void sierpinskiBitmask(LGFX &lcd);
+extern void triangles(LGFX &lcd);
+
+// Recursive turtle graphics
+extern void sevenSpirals(LGFX &lcd);
+extern void fiveKochSnowflakes(LGFX &lcd);
+extern void cCurves1(LGFX &lcd);
+extern void cCurves2(LGFX &lcd);
+extern void cCurves3(LGFX &lcd);
+extern void dragonCurves1(LGFX &lcd);
+extern void dragonCurves2(LGFX &lcd);
+extern void dragonCurves3(LGFX &lcd);
+extern void sierpinskiTriangles01(LGFX &lcd);
+extern void sierpinskiTriangles23(LGFX &lcd);
+extern void sierpinskiTriangles45(LGFX &lcd);
+extern void shamrocks02(LGFX &lcd);
+extern void shamrocks3(LGFX &lcd);
+extern void shamrocks4(LGFX &lcd);
+extern void curveGallery(LGFX &lcd);
+
+constexpr ROT  P        = ROT::PORTRAIT;
+constexpr bool UNSEEDED = false;  // draws the same image on every run
+constexpr bool SEEDED   = true;   // draws from the activity seed
+
+constexpr Activity activity[] = {  
+  // name                 function               cost          buffer       rot  seeded
+  {"RGB_Tiles",           rgbTiles,              COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Rainbow_Stripes",     rainbowStripes,        COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Color_Tiles",         colorTiles,            COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Color_Gradients",     colorGradients,        COST::MEDIUM, BUF::LINE,   P,   UNSEEDED},
+  {"Circles",             circles,               COST::MEDIUM, BUF::FRAME,  P,   SEEDED},
+  {"Rectangles",          rectangles,            COST::MEDIUM, BUF::FRAME,  P,   SEEDED},
+  {"Round_Rectangles",    roundRectangles,       COST::MEDIUM, BUF::FRAME,  P,   UNSEEDED},
+  {"Triangles",           triangles,             COST::MEDIUM, BUF::FRAME,  P,   UNSEEDED},
+  {"HSV_ColorCircle",     hsvColorCircle,        COST::MEDIUM, BUF::LINE,   P,   UNSEEDED},
+  {"Random_Dots",         randomDots,            COST::HEAVY,  BUF::DIRECT, P,   SEEDED},
+  {"Barnsley_Fern",       barnsleyFern,          COST::HEAVY,  BUF::TILE,   P,   SEEDED}, 
+  {"Mandelbrot",          mandelbrot,            COST::HEAVY,  BUF::DIRECT, P,   UNSEEDED},
+  {"Mandelbrot_Smooth",   mandelbrotSmooth,      COST::HEAVY,  BUF::LINE,   P,   UNSEEDED},
+  {"Mandelbrot_Tiles",    mandelbrotTiles,       COST::HEAVY,  BUF::TILE,   P,   UNSEEDED},
+  {"Sierpinski",          sierpinskiTriangle,    COST::HEAVY,  BUF::DIRECT, P,   SEEDED},
+  {"Sierpinski_Mask",     sierpinskiBitmask,     COST::MEDIUM, BUF::LINE,   P,   UNSEEDED},
+  {"Spirals",             sevenSpirals,          COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Snowflakes",          fiveKochSnowflakes,    COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"C_Curves1",           cCurves1,              COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"C_Curves2",           cCurves2,              COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"C_Curves3",           cCurves3,              COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Dragon_Curves1",      dragonCurves1,         COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Dragon_Curves2",      dragonCurves2,         COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Dragon_Curves3",      dragonCurves3,         COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Sierpinski_01",       sierpinskiTriangles01, COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Sierpinski_23",       sierpinskiTriangles23, COST::LIGHT,  BUF::DIRECT, P,   UNSEEDED},
+  {"Sierpinski_45",       sierpinskiTriangles45, COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Shamrocks_02",        shamrocks02,           COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Shamrocks_3",         shamrocks3,            COST::MEDIUM, BUF::DIRECT, P,   UNSEEDED},
+  {"Shamrocks_4",         shamrocks4,            COST::HEAVY,  BUF::DIRECT, P,   UNSEEDED},
+  {"Curve_Gallery",       curveGallery,          COST::MEDIUM, BUF::LINE,   P,   UNSEEDED},
+};
+constexpr int nbrActivities = sizeof(activity) / sizeof(activity[0]);
+static_assert(nbrActivities <= 100, "screenshot names use 2 digits for the activity number");
+
+ActivityStats activityStats[nbrActivities];
+int traceRequest = -1;    // activity to be recorded on its next run
+uint32_t fixedSeed = 0;   // 0: a new random seed for every run
+
+
+/**
+ * Record the draw calls of activity i on its next run (needs LGFX_TRACE)
+*/
+void requestTrace(int i)
+{
+  traceRequest = i;
+}
+
+
+/**
+ * Run all activities with the same seed, which makes their images 
+ * reproducible, or with a new random seed each run for seed 0
+*/
+void fixSeed(uint32_t seed)
+{
+  fixedSeed = seed;
+}
+
+
+void traceFilename(char *buf, size_t len, int i)
+{
+  snprintf(buf, len, "/traces/%02d_%s.dlt", i, activity[i].name);
+}
+
+
+/**
+ * FNV-1a hash of the names of all activities in their order, it
+ * changes when an activity is added, removed or moved
+*/
+uint32_t activityTableHash()
+{
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < nbrActivities; i++)
+    for (const char *c = activity[i].name; ; c++)
+    {
+      h = (h ^ (uint8_t)*c) * 16777619u;
+      if (*c == '\0') break;
+    }
+  return h;
+}
+
+
+/**
+ * Run activity i in its orientation and record 
+ * the render time and the work sent to the lcd.
+ * The render time is also added to the run log.
+ * The frame arena is emptied for the run, heap and 
+ * stack usage are compared before and after it. 
+ * With LGFX_PROFILE defined the profile of the 
+ * draw calls is output after the run, with 
+ * LGFX_TRACE a requested trace is recorded.
+*/
+void runActivity(LGFX &lcd, int i)
+{
+  const Activity &a = activity[i];
+  ActivityStats &s  = activityStats[i];
+
+  lcd.setRotation(static_cast<uint8_t>(a.rotation));
+  activitySeed = fixedSeed ? fixedSeed : esp_random();
+  renderCounters.reset();
+#ifdef LGFX_PROFILE
+  drawProfiler.reset();
+#endif
+#ifdef LGFX_TRACE
+  if (i == traceRequest)
+  {
+    char path[48];
+    traceFilename(path, sizeof(path), i);
+    SD.mkdir("/traces");
+    if (drawTrace.begin(path, activitySeed, lcd.width(), lcd.height()))
+      Serial.printf("recording %s, seed %u\n", path, activitySeed);
+    traceRequest = -1;
+  }
+#endif
+  frameArena.reset();
+  memTelemetry.before();
+  const int64_t hudUs = hud.busyUs();
+  uint32_t start = micros();
+  a.f(lcd);
+  uint32_t us = micros() - start - renderCounters.waitUs;
+  memTelemetry.after(a.name);
+  if (Hud::enabled)
+    Serial.printf("HUD %.2f ms, %.2f %% of the render time\n", (hud.busyUs() - hudUs) / 1000.0, 
+                  (hud.busyUs() - hudUs) * 100.0 / (us ? us : 1));
+#ifdef LGFX_PROFILE
+  drawProfiler.dump(a.name);
+#endif
+#ifdef LGFX_TRACE
+  if (drawTrace.isRecording())
+  {
+    drawTrace.end();
+    Serial.printf("%u commands recorded\n", drawTrace.commands());
+    char path[48];
+    traceFilename(path, sizeof(path), i);
+    sdCatalog.update(path);
+  }
+#endif
+
+  if (s.runs == 0 || us < s.minUs) s.minUs = us;
+  if (us > s.maxUs) s.maxUs = us;
+  s.totalUs += us;
+  s.runs++;
+  s.primitives   = renderCounters.primitives;
+  s.bytesFlushed = renderCounters.bytesFlushed;
+  s.listIn       = renderCounters.listIn;
+  s.listOut      = renderCounters.listOut;
+  s.seed         = activitySeed;
+  runLog.printf("%02d %-18s %8.1f ms", i, a.name, us / 1000.0);
+}
+
+
+/**
+ * Print the activity table with metadata and run statistics
+*/
+void printActivityTable()
+{
+  const char *costName[] = {"light", "medium", "heavy"};
+  const char *bufName[]  = {"direct", "line", "tile", "frame"};
+
+  Serial.printf(R"(
+Activities
+----------
+ #  name                cost    buffer  rot       seed   runs   min ms   avg ms   max ms    prims     bytes  dl in/out
+)");
+  for (int i = 0; i < nbrActivities; i++)
+  {
+    const Activity &a = activity[i];
+    const ActivityStats &s = activityStats[i];
+    uint32_t avgUs = s.runs ? s.totalUs / s.runs : 0;
+    char seed[11] = "-";
+    if (a.seeded && s.runs) snprintf(seed, sizeof(seed), "%u", s.seed);
+    // direct draw calls are only counted by the profiler
+    char prims[11] = "n/a", bytes[11] = "n/a";
+#ifndef LGFX_PROFILE
+    if (a.buffer != BUF::DIRECT)
+#endif
+    {
+      snprintf(prims, sizeof(prims), "%u", s.primitives);
+      snprintf(bytes, sizeof(bytes), "%u", s.bytesFlushed);
+    }
+    Serial.printf("%2d  %-18s  %-6s  %-6s  %3d  %10s  %5u %8.1f %8.1f %8.1f %8s %9s  %4u/%-4u\n", 
+                  i, a.name, costName[(int)a.cost], bufName[(int)a.buffer], 
+                  (int)a.rotation, seed, s.runs,
+                  s.minUs / 1000.0, avgUs / 1000.0, s.maxUs / 1000.0, 
+                  prims, bytes, s.listIn, s.listOut);
+  }
+  Serial.printf("\n");
+}
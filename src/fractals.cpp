@@ -1,9 +1,19 @@
 #include <LovyanGFX.hpp>
 #include "lgfx_ESP32_2432S028.h"
 #include "Turtle.h"
+#include "Scanline.h"
+#include "TileRenderer.h"
+#include "Rng.h"
+#include "GeometryCache.h"
+#include "AALines.h"
+#include "Arena.h"
+#include "GlyphCache.h"
+#include "VScroll.h"
+#include "RenderStats.h"
 
 extern int color[];
 extern int nbrOfColors;
+extern void HSVtoRGB565(uint16_t &rgb565, uint16_t h, float s, float v);
 constexpr float SQRT2 = 1.414213562373; 
 
 /**
@@ -92,6 +102,42 @@ void dragonCurve(Turtle &t, int n, int sign, float step)
   }  
 }
 
+// Signature of the geometry cache for the curves with other parameters
+static void cCurveGeometry(Turtle &t, int n, float step) { cCurve(t, n, step); }
+static void dragonGeometry(Turtle &t, int n, float step) { dragonCurve(t, n, 1, step); }
+
+/**
+ * Label a figure with its order n, white on black
+*/
+static void label(LGFX &lcd, int n, int x, int y)
+{
+  char s[8];
+  snprintf(s, sizeof(s), "%d", n);
+  glyphCache.drawText(lcd, s, x, y, TFT_WHITE, TFT_BLACK);
+}
+
+
+/**
+ * Draw a curve from the geometry cache at the turtle position and 
+ * leave the turtle at its end. The recursion runs only on the first 
+ * use of the curve. The curves end with their start heading.
+ * In the anti-aliased mode the curve is drawn by the AALines of the turtle.
+*/
+void cachedCurve(Turtle &t, GeometryCache::Curve curve, int n, float step)
+{
+  const Polyline *p = geometryCache.get(t, curve, n, step);
+  if (p == nullptr)
+  {
+    curve(t, n, step);
+    return;
+  }
+  AALines *aa = t.antiAliasing();
+  if (aa == nullptr || ! aa->draw(*p, t.x(), t.y()))
+    drawPolyline(t._lcd, *p, Affine::translate(t.x(), t.y()), t.penColor());
+  const Vertex &end = p->vertices()[p->count() - 1];
+  t.home(t.x() + end.x, t.y() + end.y, t.heading());
+}
+
 /**
  * Draws some spirals
 */
@@ -121,11 +167,11 @@ void sevenSpirals(LGFX &lcd)
 */
 void kochSnowflakes01234(Turtle &t)
 { 
-    t.home(30,  15, 0.0); koch(t, 0, 200); t._lcd.drawChar(48+0, 2, 15);
-    t.home(30,  50, 0.0); koch(t, 1, 200); t._lcd.drawChar(48+1, 2, 50);
-    t.home(30, 120, 0.0); koch(t, 2, 200); t._lcd.drawChar(48+2, 2, 120);
-    t.home(30, 190, 0.0); koch(t, 3, 200); t._lcd.drawChar(48+3, 2, 190);
-    t.home(30, 260, 0.0); koch(t, 4, 200); t._lcd.drawChar(48+4, 2, 260);
+    t.home(30,  15, 0.0); cachedCurve(t, koch, 0, 200); label(t._lcd, 0, 2, 15);
+    t.home(30,  50, 0.0); cachedCurve(t, koch, 1, 200); label(t._lcd, 1, 2, 50);
+    t.home(30, 120, 0.0); cachedCurve(t, koch, 2, 200); label(t._lcd, 2, 2, 120);
+    t.home(30, 190, 0.0); cachedCurve(t, koch, 3, 200); label(t._lcd, 3, 2, 190);
+    t.home(30, 260, 0.0); cachedCurve(t, koch, 4, 200); label(t._lcd, 4, 2, 260);
 }
 
 
@@ -141,10 +187,10 @@ void fiveKochSnowflakes(LGFX &lcd)
 */
 void cCurves0123(Turtle &t)
 {
-  t.home(41,  15, 0.0); cCurve(t, 0, 160); t._lcd.drawChar(48+0, 2, 15);
-  t.home(41,  40, 0.0); cCurve(t, 1, 160); t._lcd.drawChar(48+1, 2, 40);
-  t.home(41,  90, 0.0); cCurve(t, 2, 160); t._lcd.drawChar(48+2, 2, 90);
-  t.home(41, 190, 0.0); cCurve(t, 3, 160); t._lcd.drawChar(48+3, 2, 190);
+  t.home(41,  15, 0.0); cachedCurve(t, cCurveGeometry, 0, 160); label(t._lcd, 0, 2, 15);
+  t.home(41,  40, 0.0); cachedCurve(t, cCurveGeometry, 1, 160); label(t._lcd, 1, 2, 40);
+  t.home(41,  90, 0.0); cachedCurve(t, cCurveGeometry, 2, 160); label(t._lcd, 2, 2, 90);
+  t.home(41, 190, 0.0); cachedCurve(t, cCurveGeometry, 3, 160); label(t._lcd, 3, 2, 190);
 }
 
 
@@ -160,9 +206,9 @@ void cCurves1(LGFX &lcd)
 */
 void cCurves456(Turtle &t)
 {
-  t.home(69,  15, 0.0); cCurve(t, 4, 120); t._lcd.drawChar(48+4, 2, 15);
-  t.home(69, 120, 0.0); cCurve(t, 5, 120); t._lcd.drawChar(48+5, 2, 120);
-  t.home(69, 225, 0.0); cCurve(t, 6, 120); t._lcd.drawChar(48+6, 2, 225);
+  t.home(69,  15, 0.0); cachedCurve(t, cCurveGeometry, 4, 120); label(t._lcd, 4, 2, 15);
+  t.home(69, 120, 0.0); cachedCurve(t, cCurveGeometry, 5, 120); label(t._lcd, 5, 2, 120);
+  t.home(69, 225, 0.0); cachedCurve(t, cCurveGeometry, 6, 120); label(t._lcd, 6, 2, 225);
 }
 
 
@@ -178,9 +224,9 @@ void cCurves2(LGFX &lcd)
 */
 void cCurves789(Turtle &t)
 {
-  t.home(69,  25, 0.0); cCurve(t, 7, 110); t._lcd.drawChar(48+7, 2, 25);
-  t.home(69, 145, 0.0); cCurve(t, 8, 110); t._lcd.drawChar(48+8, 2, 145);
-  t.home(69, 245, 0.0); cCurve(t, 9, 110); t._lcd.drawChar(48+9, 2, 245);
+  t.home(69,  25, 0.0); cachedCurve(t, cCurveGeometry, 7, 110); label(t._lcd, 7, 2, 25);
+  t.home(69, 145, 0.0); cachedCurve(t, cCurveGeometry, 8, 110); label(t._lcd, 8, 2, 145);
+  t.home(69, 245, 0.0); cachedCurve(t, cCurveGeometry, 9, 110); label(t._lcd, 9, 2, 245);
 }
 
 
@@ -196,10 +242,10 @@ void cCurves3(LGFX &lcd)
 */
 void dragonCurves0123(Turtle &t)
 {
-  t.home(60,  15, 0.0); dragonCurve(t, 0, 1, 150.0); t._lcd.drawChar(48+0, 2, 15);
-  t.home(60,  40, 0.0); dragonCurve(t, 1, 1, 150.0); t._lcd.drawChar(48+1, 2, 40);
-  t.home(60, 135, 0.0); dragonCurve(t, 2, 1, 150.0); t._lcd.drawChar(48+2, 2, 135);
-  t.home(60, 235, 0.0); dragonCurve(t, 3, 1, 150.0); t._lcd.drawChar(48+3, 2, 235);
+  t.home(60,  15, 0.0); cachedCurve(t, dragonGeometry, 0, 150.0); label(t._lcd, 0, 2, 15);
+  t.home(60,  40, 0.0); cachedCurve(t, dragonGeometry, 1, 150.0); label(t._lcd, 1, 2, 40);
+  t.home(60, 135, 0.0); cachedCurve(t, dragonGeometry, 2, 150.0); label(t._lcd, 2, 2, 135);
+  t.home(60, 235, 0.0); cachedCurve(t, dragonGeometry, 3, 150.0); label(t._lcd, 3, 2, 235);
 }
 
 
@@ -215,9 +261,9 @@ void dragonCurves1(LGFX &lcd)
 */
 void dragonCurves456(Turtle &t)
 {
-  t.home(70,  32, 0.0); dragonCurve(t, 4, 1, 120.0); t._lcd.drawChar(48+4, 2, 32);
-  t.home(70, 130, 0.0); dragonCurve(t, 5, 1, 120.0); t._lcd.drawChar(48+5, 2, 130);
-  t.home(70, 240, 0.0); dragonCurve(t, 6, 1, 120.0); t._lcd.drawChar(48+6, 2, 240);
+  t.home(70,  32, 0.0); cachedCurve(t, dragonGeometry, 4, 120.0); label(t._lcd, 4, 2, 32);
+  t.home(70, 130, 0.0); cachedCurve(t, dragonGeometry, 5, 120.0); label(t._lcd, 5, 2, 130);
+  t.home(70, 240, 0.0); cachedCurve(t, dragonGeometry, 6, 120.0); label(t._lcd, 6, 2, 240);
 }
 
 
@@ -233,9 +279,9 @@ void dragonCurves2(LGFX &lcd)
 */
 void dragonCurves789(Turtle &t)
 {
-  t.home(70,  35, 0.0); dragonCurve(t, 7, 1, 100.0); t._lcd.drawChar(48+7, 2, 35);
-  t.home(70, 140, 0.0); dragonCurve(t, 8, 1, 100.0); t._lcd.drawChar(48+8, 2, 140);
-  t.home(70, 250, 0.0); dragonCurve(t, 9, 1, 100.0); t._lcd.drawChar(48+9, 2, 250);
+  t.home(70,  35, 0.0); cachedCurve(t, dragonGeometry, 7, 100.0); label(t._lcd, 7, 2, 35);
+  t.home(70, 140, 0.0); cachedCurve(t, dragonGeometry, 8, 100.0); label(t._lcd, 8, 2, 140);
+  t.home(70, 250, 0.0); cachedCurve(t, dragonGeometry, 9, 100.0); label(t._lcd, 9, 2, 250);
 }
 
 
@@ -246,6 +292,146 @@ void dragonCurves3(LGFX &lcd)
 }
 
 
+/**
+ * Time of the dragon curves of order 7 to 9 aliased and anti-aliased,
+ * the curves come from the geometry cache in both runs
+*/
+void benchmarkCurves(LGFX &lcd)
+{
+  const bool enabled = AALines::enabled;
+  uint32_t us[2];
+  for (int aa = 0; aa < 2; aa++)
+  {
+    AALines::enabled = aa;
+    {
+      Turtle t(lcd, lcd.width()/2, lcd.height()/2, 0.0);
+      dragonCurves789(t);         // fills the cache
+    }
+    Turtle t(lcd, lcd.width()/2, lcd.height()/2, 0.0);
+    uint32_t start = micros();
+    dragonCurves789(t);
+    us[aa] = micros() - start;
+  }
+  AALines::enabled = enabled;
+
+  Serial.printf("dragon curves 7 to 9\n");
+  Serial.printf("aliased       %7u us\n", us[0]);
+  Serial.printf("anti-aliased  %7u us  %.2fx\n", us[1], (float)us[1] / us[0]);
+}
+
+
+/**
+ * Curve gallery
+ * 
+ * The C curves and dragon curves of order 0 to 9 and the Koch curves 
+ * of order 0 to 4 one below the other, each as large as on its own 
+ * page, in a column much taller than the screen. The column scrolls 
+ * by with the hardware scrolling of the panel, only the rows coming 
+ * into view are rendered: the lines of the curves from their cached 
+ * polylines, crossing the row, and the labels from the glyph cache.
+*/
+struct GalleryItem
+{
+  const Polyline *p;
+  int x, y;                 // translation of the polyline in the column
+  int top, bottom;          // rows of the item with its label
+  uint16_t color;
+  char label[12];
+};
+
+constexpr int GALLERY_ITEMS  = 25;
+constexpr int GALLERY_GAP    = 12;    // rows between the items
+constexpr int GALLERY_SPEED  = 4;     // rows per frame
+constexpr uint32_t GALLERY_TICK_MS = 16;
+constexpr int GALLERY_STRIDE = (VScroll::MAX_WIDTH + 31) / 32;
+static GalleryItem gallery[GALLERY_ITEMS];
+static int galleryItems = 0;
+
+
+static void galleryRow(int c, uint16_t *line, int width, void *ctx)
+{
+  for (int x = 0; x < width; x++) line[x] = TFT_BLACK;
+  uint32_t mask[GALLERY_STRIDE] = {0};
+  bool hasText = false;
+  for (int i = 0; i < galleryItems; i++)
+  {
+    const GalleryItem &g = gallery[i];
+    if (c < g.top || c >= g.bottom) continue;
+    polylineRow(*g.p, g.x, g.y, c, line, width, Scanline::swap(g.color));
+    if (c >= g.top + glyphCache.height()) continue;
+    int x = 2;
+    for (const char *ch = g.label; *ch; ch++)
+    {
+      glyphCache.drawMask(*ch, mask, GALLERY_STRIDE, 1, x, g.top - c);
+      x += glyphCache.advance(*ch);
+    }
+    hasText = true;
+  }
+  for (int x = 0; hasText && x < width; x++)
+    if (mask[x >> 5] & (1u << (x & 31))) line[x] = TFT_WHITE;
+}
+
+
+void curveGallery(LGFX &lcd)
+{
+  struct { GeometryCache::Curve curve; const char *name; int order; float step; uint16_t color; } spec[] =
+  {
+    // the steps of the curve pages, which have cached them already
+    {cCurveGeometry, "C", 0, 160, TFT_CYAN},   {cCurveGeometry, "C", 1, 160, TFT_CYAN},
+    {cCurveGeometry, "C", 2, 160, TFT_CYAN},   {cCurveGeometry, "C", 3, 160, TFT_CYAN},
+    {cCurveGeometry, "C", 4, 120, TFT_CYAN},   {cCurveGeometry, "C", 5, 120, TFT_CYAN},
+    {cCurveGeometry, "C", 6, 120, TFT_CYAN},   {cCurveGeometry, "C", 7, 110, TFT_CYAN},
+    {cCurveGeometry, "C", 8, 110, TFT_CYAN},   {cCurveGeometry, "C", 9, 110, TFT_CYAN},
+    {dragonGeometry, "Dragon", 0, 150, TFT_ORANGE}, {dragonGeometry, "Dragon", 1, 150, TFT_ORANGE},
+    {dragonGeometry, "Dragon", 2, 150, TFT_ORANGE}, {dragonGeometry, "Dragon", 3, 150, TFT_ORANGE},
+    {dragonGeometry, "Dragon", 4, 120, TFT_ORANGE}, {dragonGeometry, "Dragon", 5, 120, TFT_ORANGE},
+    {dragonGeometry, "Dragon", 6, 120, TFT_ORANGE}, {dragonGeometry, "Dragon", 7, 100, TFT_ORANGE},
+    {dragonGeometry, "Dragon", 8, 100, TFT_ORANGE}, {dragonGeometry, "Dragon", 9, 100, TFT_ORANGE},
+    {koch, "Koch", 0, 200, TFT_WHITE}, {koch, "Koch", 1, 200, TFT_WHITE}, {koch, "Koch", 2, 200, TFT_WHITE},
+    {koch, "Koch", 3, 200, TFT_WHITE}, {koch, "Koch", 4, 200, TFT_WHITE},
+  };
+  static_assert(sizeof(spec) / sizeof(spec[0]) <= GALLERY_ITEMS, "too many curves for the gallery");
+
+  // lay out the column, the curves are expanded only when not yet cached
+  Turtle t(lcd, 0, 0, 0.0);
+  int y = GALLERY_GAP;
+  galleryItems = 0;
+  for (const auto &c : spec)
+  {
+    const Polyline *p = geometryCache.get(t, c.curve, c.order, c.step);
+    if (p == nullptr) continue;               // cache full
+    int x0, y0, x1, y1;
+    p->bounds(x0, y0, x1, y1);
+    GalleryItem &g = gallery[galleryItems++];
+    g.p = p;
+    g.color = c.color;
+    snprintf(g.label, sizeof(g.label), "%s %d", c.name, c.order);
+    g.top = y;
+    g.x = (lcd.width() - (x1 - x0)) / 2 - x0;
+    g.y = y + glyphCache.height() + 4 - y0;
+    g.bottom = g.y + y1 + 1;
+    y = g.bottom + GALLERY_GAP;
+  }
+
+  // the pauses between the frames are not render time
+  VScroll vs(lcd);
+  if (! vs.begin(0, 0, galleryRow, nullptr)) return;
+  delay(500);
+  renderCounters.waitUs += 500000;
+  for (int offset = 0; offset < y - vs.height(); offset += GALLERY_SPEED)
+  {
+    uint32_t tick = millis();
+    vs.scrollTo(offset);
+    int32_t wait = GALLERY_TICK_MS - (millis() - tick);
+    if (wait <= 0) continue;
+    delay(wait);
+    renderCounters.waitUs += wait * 1000;
+  }
+  vs.scrollTo(std::max(0, y - vs.height()));
+  vs.end(true);             // the Koch curves stay on the screen
+}
+
+
 /**
  * Recursive Sierpinski Triangle
  * 
@@ -285,27 +471,27 @@ void sierpinskiRecursive(Turtle &t, int n, float step)
 void sierpinskiTriangles01(LGFX &lcd)
 {
   Turtle t(lcd, 45, 5, 0.0);
-  sierpinskiRecursive(t, 0, 170); lcd.drawChar(48, 5, 15);
+  sierpinskiRecursive(t, 0, 170); label(lcd, 0, 5, 15);
   t.home(45, 165, 0.0);
-  sierpinskiRecursive(t, 1, 170); lcd.drawChar(49, 5, 175);
+  sierpinskiRecursive(t, 1, 170); label(lcd, 1, 5, 175);
 }
 
 
 void sierpinskiTriangles23(LGFX &lcd)
 {
   Turtle t(lcd, 45, 5, 0.0);
-  sierpinskiRecursive(t, 2, 170); lcd.drawChar(50, 5, 15);
+  sierpinskiRecursive(t, 2, 170); label(lcd, 2, 5, 15);
   t.home(45, 165, 0.0);
-  sierpinskiRecursive(t, 3, 170); lcd.drawChar(51, 5, 175);
+  sierpinskiRecursive(t, 3, 170); label(lcd, 3, 5, 175);
 }
 
 
 void sierpinskiTriangles45(LGFX &lcd)
 {
   Turtle t(lcd, 45, 5, 0.0);
-  sierpinskiRecursive(t, 4, 170); lcd.drawChar(52, 5, 15);
+  sierpinskiRecursive(t, 4, 170); label(lcd, 4, 5, 15);
   t.home(45, 165, 0.0);
-  sierpinskiRecursive(t, 5, 170); lcd.drawChar(53, 5, 175);
+  sierpinskiRecursive(t, 5, 170); label(lcd, 5, 5, 175);
 }
 
 
@@ -363,11 +549,11 @@ void shamrock(Turtle &t, int order, float step)
 void shamrocks02(LGFX &lcd)
 {
   Turtle t(lcd, 25, 5, 90.0);
-  lcd.drawChar(48, 5, 15); shamrock(t, 0, 30); 
+  label(lcd, 0, 5, 15); shamrock(t, 0, 30); 
   t.home(150, 5, 90.0);
-  lcd.drawChar(49, 130, 15); shamrock(t, 1, 30); 
+  label(lcd, 1, 130, 15); shamrock(t, 1, 30); 
   t.home(25, 110, 90.0);
-  lcd.drawChar(50, 5, 120); shamrock(t, 2, 120); 
+  label(lcd, 2, 5, 120); shamrock(t, 2, 120); 
 }
 
 
@@ -377,7 +563,7 @@ void shamrocks02(LGFX &lcd)
 void shamrocks3(LGFX &lcd)
 {
   Turtle t(lcd, 5, 25, 90.0);
-  lcd.drawChar(51, 5, 15); shamrock(t, 3, 180);
+  label(lcd, 3, 5, 15); shamrock(t, 3, 180);
 }
 
 
@@ -387,28 +573,37 @@ void shamrocks3(LGFX &lcd)
 void shamrocks4(LGFX &lcd)
 {
   Turtle t(lcd, 5, 25, 90.0);
-  lcd.drawChar(52, 5, 15); shamrock(t, 4, 243);
+  label(lcd, 4, 5, 15); shamrock(t, 4, 243);
 }
 
 
 /**
  * Draws a self-similar fractal pattern known as "Barnsleys Fern" 
 */
-void barnsleyFern(LGFX &lcd) 
+struct Fern
 {
-  uint8_t savedRotation = lcd.getRotation(); 
+  PointMap *map;
+  int w, h;
+  int points;
+};
+
+/**
+ * Each worker iterates its own orbit with its own random stream 
+ * and plots it into the point map
+*/
+static void fernJob(int worker, void *ctx)
+{
+  const Fern &fern = *(Fern*)ctx;
+  Rng rng = activityRng(worker);
   float x = 0;
   float y = 0;
 
-  lcd.fillScreen(TFT_BLACK);
-  lcd.setRotation(0); // Set orienation to Portrait
-
-  for (unsigned int i = 0; i < 32000; i++) 
+  for (int i = 0; i < fern.points; i++) 
   {
     float xt = 0;
     float yt = 0;
  
-    int r = random(0, 100);
+    int r = rng.below(100);
  
     if (r <= 1) 
     {
@@ -431,11 +626,40 @@ void barnsleyFern(LGFX &lcd)
     x = xt;
     y = yt;
  
-    int m = round(lcd.width()/2 + 32*x);
-    int n = lcd.height()-round(30*y);
+    int m = round(fern.w/2 + 32*x);
+    int n = fern.h-round(30*y);
  
-    lcd.drawPixel(m, n, TFT_GREEN);
+    fern.map->plot(m, n, 1);
+  }
+}
+
+/**
+ * The 32000 points are computed by both cores into a point map,
+ * which is then rendered in tiles.
+*/
+void barnsleyFern(LGFX &lcd) 
+{
+  uint8_t savedRotation = lcd.getRotation(); 
+  const uint16_t palette[4] = { TFT_BLACK, TFT_GREEN, TFT_GREEN, TFT_GREEN };
+
+  lcd.setRotation(0); // Set orienation to Portrait
+  Fern fern = { nullptr, lcd.width(), lcd.height(), 32000 / nbrTileWorkers };
+  ArenaScope scope(frameArena);
+  uint32_t *buf = frameArena.alloc<uint32_t>(PointMap::words(fern.w, fern.h));
+  if (buf == nullptr)
+  {
+    log_e("No memory for the point map");
+    lcd.setRotation(savedRotation);
+    return;
   }
+  PointMap map(buf, fern.w, fern.h, palette);
+  TileRenderer renderer(fern.w, fern.h);
+  fern.map = &map;
+
+  map.clear();
+  runOnWorkers(fernJob, &fern);
+  renderTiles(lcd, renderer, map);
+
   lcd.setRotation(savedRotation);
   lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
 }
@@ -484,6 +708,145 @@ void mandelbrot(LGFX &lcd)
   lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
 }
 
+// Gradient used by the smooth coloring of the Mandelbrot set
+constexpr int GRADIENT_LUT_BITS = 8;
+constexpr int GRADIENT_LUT_SIZE = 1 << GRADIENT_LUT_BITS;
+constexpr int COLORS_PER_ITERATION = 8;     // LUT entries spanned by one iteration step
+constexpr float SMOOTH_BAILOUT = 256.0;     // |z|^2 > 256, i.e. |z| > 16
+uint16_t gradientLUT[GRADIENT_LUT_SIZE];
+
+/**
+ * Fill the gradient LUT once with a full turn of the HSV color circle
+*/
+void initGradientLUT()
+{
+  static bool isInitialized = false;
+  if (isInitialized) return;
+  for (int i = 0; i < GRADIENT_LUT_SIZE; i++)
+  {
+    HSVtoRGB565(gradientLUT[i], i * 360 / GRADIENT_LUT_SIZE, 1.0, 0.9);
+  }
+  isInitialized = true;
+}
+
+/**
+ * Fixed point approximation of log2(v) with v and the result in Q16.16.
+ * The integer part is the position of the highest set bit, the fraction 
+ * is taken linearly from the bits below it (Mitchell's approximation, 
+ * max. error 0.086). v must not be 0.
+*/
+inline int32_t log2Q16(uint32_t v)
+{
+  int msb = 31 - __builtin_clz(v);
+  uint32_t frac = msb >= 16 ? v >> (msb - 16) : v << (16 - msb);
+  return ((msb - 16) << 16) + (frac & 0xFFFF);
+}
+
+/**
+ * The same approximation applied to the bits of a positive float:
+ * exponent and mantissa are already the integer and fractional 
+ * part of log2(f). Returns log2(f) in Q16.16.
+*/
+inline int32_t log2Q16(float f)
+{
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  return ((int32_t)bits - (127 << 23)) >> 7;
+}
+
+/**
+ * Smooth color of the point c in the Mandelbrot set, byte swapped.
+ * The normalized iteration count nu = n + 1 - log2(log2|z|) selects 
+ * the color from the gradient LUT. Both logarithms are computed with 
+ * the fixed point approximations above, so there is no log() per pixel.
+*/
+uint16_t smoothColor(float c_re, float c_im, int maxIteration)
+{
+  float x = 0, y = 0, xx = 0, yy = 0;
+  int iteration = 0;
+  while (xx + yy <= SMOOTH_BAILOUT && iteration < maxIteration)
+  {
+    y = 2*x*y + c_im;
+    x = xx - yy + c_re;
+    xx = x*x;
+    yy = y*y;
+    iteration++;
+  }
+  if (iteration == maxIteration) return TFT_BLACK;
+  int32_t log2AbsZ = log2Q16(xx + yy) >> 1;         // log2|z| = log2(|z|^2) / 2
+  int32_t nu = ((iteration + 1) << 16) - log2Q16((uint32_t)log2AbsZ);
+  if (nu < 0) nu = 0;
+  return Scanline::swap(gradientLUT[(nu * COLORS_PER_ITERATION >> 16) & (GRADIENT_LUT_SIZE - 1)]);
+}
+
+/**
+ * Draws "Mandelbrot's Apple Man" with smooth coloring.
+ * Each row is computed into a line buffer and pushed with one DMA write.
+*/
+void mandelbrotSmooth(LGFX &lcd)
+{
+  uint8_t savedRotation = lcd.getRotation();
+  int maxIteration = 1000;
+  lcd.setRotation(0); // Set orientation to Portrait
+  int w = lcd.width();
+  int h = lcd.height();
+  Scanline sl(lcd);
+
+  initGradientLUT();
+  sl.begin();
+  for(int zeile = 0; zeile < h; zeile++)
+  {
+    uint16_t *line = sl.line();
+    float c_im = (zeile- h/2.0) * 4.0 / h;
+    for(int spalte = 0; spalte < w; spalte++)
+    {
+      float c_re = (spalte - w/2.0) * 4.0 / w;
+      line[spalte] = smoothColor(c_re, c_im, maxIteration);
+    }
+    sl.flush(0, zeile, w);
+  }
+  sl.end();
+  lcd.setRotation(savedRotation);
+  lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
+}
+
+struct View
+{
+  int w, h;
+};
+
+static void mandelbrotTile(Tile &t, void *ctx)
+{
+  const View &v = *(View*)ctx;
+  uint16_t *p = t.pixels;
+  for (int zeile = t.y; zeile < t.y + t.h; zeile++)
+  {
+    float c_im = (zeile - v.h/2.0) * 4.0 / v.h;
+    for (int spalte = t.x; spalte < t.x + t.w; spalte++)
+      *p++ = smoothColor((spalte - v.w/2.0) * 4.0 / v.w, c_im, 1000);
+  }
+}
+
+/**
+ * The smooth Mandelbrot set rendered in tiles by both cores.
+ * Tiles inside the set take much longer than the others, the 
+ * work stealing keeps both cores busy until the last tile.
+*/
+void mandelbrotTiles(LGFX &lcd)
+{
+  uint8_t savedRotation = lcd.getRotation();
+  lcd.setRotation(0); // Set orientation to Portrait
+  View view = { lcd.width(), lcd.height() };
+  TileRenderer renderer(view.w, view.h);
+  ShaderSource shader(mandelbrotTile, &view);
+
+  initGradientLUT();
+  renderTiles(lcd, renderer, shader);
+  renderer.printStats();
+  lcd.setRotation(savedRotation);
+  lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
+}
+
 /**
  * Draws the fractal known as "Sierpinskys Triangle"
  * Recipe: 
@@ -499,11 +862,12 @@ void sierpinskiTriangle(LGFX &lcd)
   int farbe[] = {TFT_RED, TFT_BLUE, TFT_GREEN};
   int p[] = {20,20};
   int k, x, y, mx, my;
+  Rng rng = activityRng();
   
   lcd.fillScreen(TFT_BLACK);
   for(int i = 0; i < 32000; i++)
   {
-    k = random(0,3);
+    k = rng.below(3);
     x = ecke[k][0];
     y = ecke[k][1];
     mx = (x-p[0])/2 + p[0]; 
@@ -514,3 +878,82 @@ void sierpinskiTriangle(LGFX &lcd)
   }
   lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
 }
+
+
+/**
+ * Sierpinski triangle as a bitmask
+ * 
+ * Pascal's triangle modulo 2 is the Sierpinski triangle: with u, v 
+ * the coordinates along two sides of a triangle (0 .. 2^n), a point 
+ * belongs to the gasket if (u & v) == 0. The triangle is that of the 
+ * chaos game, (0,0), (w,0) and (w/2,h) with the apex at (w/2,h). 
+ * u grows towards (0,0) and v towards (w,0).
+ * 
+ * Each row is built as a bit pattern, u and v change linearly along 
+ * the row (Q16 steps). The bit pattern is converted to RGB565 in one 
+ * pass, whole empty words become background runs. 
+ * 
+ * level 0 draws the gasket in one color. level n colors each point by 
+ * the corner of the sub triangle of depth n it lies in, i.e. by bit 
+ * SIERPINSKI_BITS - n of u and v. Level 1 gives the colors of the chaos 
+ * game: red at (0,0), blue at (w,0) and green at the apex.
+*/
+constexpr int SIERPINSKI_BITS = 8;    // 256 cells along each side, about one per pixel
+
+void sierpinskiMask(LGFX &lcd, int level)
+{
+  const int w = lcd.width();
+  const int h = lcd.height();
+  const int32_t n = 1 << SIERPINSKI_BITS;
+  const int32_t step = (n << 16) / w;
+  const int shift = level > 0 ? SIERPINSKI_BITS - level : 0;
+  const uint16_t palette[4] = { Scanline::swap(level ? TFT_GREEN : TFT_WHITE), Scanline::swap(TFT_RED), 
+                                Scanline::swap(TFT_BLUE), 0 };
+  constexpr int WORDS = Scanline::MAX_WIDTH / 32;
+  uint32_t filled[WORDS], uBit[WORDS], vBit[WORDS];
+  Scanline sl(lcd);
+
+  sl.begin();
+  for (int y = 0; y < h; y++)
+  {
+    int32_t s = ((int64_t)n << 16) * (2*h - y) / (2*h);   // u at x = 0 in Q16
+    int32_t t = -(((int64_t)n << 16) * y / (2*h));         // v at x = 0 in Q16
+    memset(filled, 0, sizeof(filled));
+    memset(uBit, 0, sizeof(uBit));
+    memset(vBit, 0, sizeof(vBit));
+    for (int x = 0; x < w; x++, s -= step, t += step)
+    {
+      if (s < 0 || t < 0) continue;
+      uint32_t u = s >> 16, v = t >> 16;
+      if (u & v) continue;
+      uint32_t bit = 1u << (x & 31);
+      filled[x >> 5] |= bit;
+      if ((u >> shift) & 1) uBit[x >> 5] |= bit;
+      if ((v >> shift) & 1) vBit[x >> 5] |= bit;
+    }
+
+    uint16_t *line = sl.line();
+    for (int x = 0; x < w; x += 32)
+    {
+      int len = w - x < 32 ? w - x : 32;
+      uint32_t f = filled[x >> 5];
+      if (f == 0)
+      {
+        for (int i = 0; i < len; i++) line[x + i] = TFT_BLACK;
+        continue;
+      }
+      uint32_t ub = level ? uBit[x >> 5] : 0, vb = level ? vBit[x >> 5] : 0;
+      for (int i = 0; i < len; i++)
+        line[x + i] = (f >> i) & 1 ? palette[((ub >> i) & 1) | ((vb >> i) & 1) << 1] : TFT_BLACK;
+    }
+    sl.flush(0, y, w);
+  }
+  sl.end();
+}
+
+
+void sierpinskiBitmask(LGFX &lcd)
+{
+  sierpinskiMask(lcd, 1);
+  lcd.drawRect(0, 0, lcd.width(), lcd.height(), TFT_GOLD);
+}
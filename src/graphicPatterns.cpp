@@ -1,6 +1,12 @@
 
 #include <LovyanGFX.hpp>
 #include "lgfx_ESP32_2432S028.h"
+#include "Scanline.h"
+#include "DisplayList.h"
+#include "StripBuffer.h"
+#include "Rng.h"
+#include "FramePipeline.h"
+#include "Arena.h"
 
 extern int color[];
 extern int nbrOfColors;
@@ -91,34 +97,62 @@ void HSVtoRGB565(uint16_t &rgb565, uint16_t h, float s, float v )
 
 /**
  * Draws horizontal gradient lines from left to the diagonal (top-left, bottem-right)
- * and vertical gradient lines from top to the diagonal
+ * and vertical gradient lines from top to the diagonal.
+ * Instead of drawing 2 gradient lines per row, each row is computed 
+ * in one pass: left of the diagonal the pixel belongs to the horizontal 
+ * line of its row, right of it to the vertical line of its column.
 */
 void colorGradients(LGFX &lcd)
 {
   int w = lcd.width();
   int h = lcd.height();
-  lcd.fillScreen(TFT_RED);
+  Scanline sl(lcd);
+  ArenaScope scope(frameArena);
+  int32_t *recip = frameArena.alloc<int32_t>(w);    // Q16 advance of the vertical gradient per row, for each column
+  if (recip == nullptr)
+  {
+    log_e("No memory for the gradient steps");
+    return;
+  }
+
+  for (int x = 0; x < w; ++x)
+  {
+    int len = x * h / w;      // length of the vertical line through this column
+    recip[x] = len > 0 ? 65536 / len : 65536;
+  }
 
+  sl.begin();
   for (int y = 0; y < h; ++y)
   {
-    lcd.drawGradientHLine(0,     y, y*w/h, TFT_GREEN, TFT_RED); // horizontal line from left to the diagonal
-    lcd.drawGradientVLine(y*w/h, 0, y,     TFT_BLUE,  TFT_RED); // vertical   line from top  to the diagonal
+    uint16_t *line = sl.line();
+    int d = y * w / h;        // column of the diagonal
+    if (d > 0) Scanline::span(line, d, TFT_GREEN, TFT_RED, 0, 65536 / d);
+    for (int x = d; x < w; ++x)
+    {
+      line[x] = Scanline::swap(Scanline::lerp565(TFT_BLUE, TFT_RED, std::min(y * recip[x], 65536)));
+    }
+    sl.flush(0, y, w);
   }
+  sl.end();
 }
 
 
 /**
  * Draws a RBG boarder around the screen, each
  * color is 2 pixel wide. Blue is in the middle.
+ * The 6 rectangles are sent as compiled display list.
 */
 void rgbFrame(LGFX &lcd)
 {
-  lcd.drawRect(0, 0, lcd.width(),    lcd.height(),    TFT_RED);
-  lcd.drawRect(1, 1, lcd.width()-2,  lcd.height()-2,  TFT_RED);
-  lcd.drawRect(2, 2, lcd.width()-4,  lcd.height()-4,  TFT_BLUE);
-  lcd.drawRect(3, 3, lcd.width()-6,  lcd.height()-6,  TFT_BLUE);
-  lcd.drawRect(4, 4, lcd.width()-8,  lcd.height()-8,  TFT_GREEN);
-  lcd.drawRect(5, 5, lcd.width()-10, lcd.height()-10, TFT_GREEN);
+  StaticDisplayList<32> dl;
+  dl.begin(lcd.width(), lcd.height());
+  dl.drawRect(0, 0, lcd.width(),    lcd.height(),    TFT_RED);
+  dl.drawRect(1, 1, lcd.width()-2,  lcd.height()-2,  TFT_RED);
+  dl.drawRect(2, 2, lcd.width()-4,  lcd.height()-4,  TFT_BLUE);
+  dl.drawRect(3, 3, lcd.width()-6,  lcd.height()-6,  TFT_BLUE);
+  dl.drawRect(4, 4, lcd.width()-8,  lcd.height()-8,  TFT_GREEN);
+  dl.drawRect(5, 5, lcd.width()-10, lcd.height()-10, TFT_GREEN);
+  dl.flush(lcd);
 }
 
 
@@ -195,62 +229,142 @@ void rainbowStripes(LGFX &lcd)
 }
 
 
+constexpr int NBR_DOTS = 32000;
+
 /**
- * Random random color dots
+ * The dots drawn one by one with fillCircle, each circle sends one 
+ * short line per row
 */
-void randomDots(LGFX &lcd)
+void randomDotsDirect(LGFX &lcd, uint32_t seed)
 {
+  Rng rnd(seed);
+  int w = lcd.width();
+  int h = lcd.height();
+
   lcd.fillScreen(TFT_BLACK);
-  
-  for(unsigned int i = 0; i < 32000; i++)
+  for (int i = 0; i < NBR_DOTS; i++)
   {
-    int x = random(0, lcd.width());
-    int y = random(0, lcd.height());
-    lcd.fillCircle(x, y, random(1, 12), color[random(0,nbrOfColors)]);  
+    int x = rnd.below(w);
+    int y = rnd.below(h);
+    int r = 1 + rnd.below(11);
+    lcd.fillCircle(x, y, r, color[rnd.below(nbrOfColors)]);
   }
-  rgbFrame(lcd);
 }
 
 
 /**
- * Draws shrinking rectangles
+ * The same dots rasterized as spans into strips of 16 rows. 
+ * Each strip goes to the lcd with one DMA write. The strips draw 
+ * the same dots, so the generator restarts from the seed for each.
 */
-void rectangles(LGFX &lcd)
+void randomDotsStrips(LGFX &lcd, uint32_t seed)
 {
-  lcd.fillScreen(TFT_BLACK);
-
+  StripBuffer sb(lcd);
   int w = lcd.width();
   int h = lcd.height();
 
-  for (int i = 0; i < w/2; i += 5)
+  if (!sb.begin())
+  {
+    randomDotsDirect(lcd, seed);
+    return;
+  }
+  for (int top = 0; top < h; top += sb.rows())
   {
-    lcd.drawRect(i, i, w-2*i, h-2*i, color[random(0,nbrOfColors)]);
-    delay(50);  
+    Rng rnd(seed);
+    sb.start(top, TFT_BLACK);
+    for (int i = 0; i < NBR_DOTS; i++)
+    {
+      int x = rnd.below(w);
+      int y = rnd.below(h);
+      int r = 1 + rnd.below(11);
+      int c = color[rnd.below(nbrOfColors)];
+      if (y + r >= top && y - r < sb.bottom()) sb.fillCircle(x, y, r, c);
+    }
+    sb.flush();
   }
+  sb.end();
+}
+
+
+/**
+ * Random random color dots
+*/
+void randomDots(LGFX &lcd)
+{
+  randomDotsStrips(lcd, activitySeed);
   rgbFrame(lcd);
 }
 
 
 /**
- * Draws rounded rectangles
+ * Draw the same dots with a fixed seed both ways and report 
+ * circles per second
 */
-void roundRectangles(LGFX &lcd) 
+void benchmarkDots(LGFX &lcd, uint32_t seed)
 {
-  lcd.fillScreen(TFT_BLACK);
+  uint32_t start = micros();
+  randomDotsDirect(lcd, seed);
+  uint32_t direct = micros() - start;
 
-  int w = lcd.width();
+  start = micros();
+  randomDotsStrips(lcd, seed);
+  uint32_t strips = micros() - start;
+
+  Serial.printf("%d dots, seed %u\n", NBR_DOTS, seed);
+  Serial.printf("fillCircle  %7u us %8.0f circles/s\n", direct, NBR_DOTS * 1e6 / direct);
+  Serial.printf("strips      %7u us %8.0f circles/s  %.1fx\n", strips, NBR_DOTS * 1e6 / strips, (float)direct / strips);
+}
+
+
+/**
+ * Draws shrinking rectangles, frame n shows the first n+1 of them.
+ * The colors are drawn from the activity seed again for each frame.
+*/
+static void rectanglesFrame(LovyanGFX &canvas, int y0, int frame, void *ctx)
+{
+  Rng rng = activityRng();
+  int w = canvas.width();
+  int h = *(int*)ctx;
+
+  for (int i = 0; i <= 5*frame; i += 5)
+    canvas.drawRect(i, i - y0, w-2*i, h-2*i, color[rng.below(nbrOfColors)]);
+}
+
+void rectangles(LGFX &lcd)
+{
   int h = lcd.height();
-  int rectH =40;
-  int rectR = 15;
+  FramePipeline fp(lcd);
+
+  fp.run((lcd.width()/2 + 4) / 5, rectanglesFrame, &h);
+  FramePipeline::print("Rectangles");
+  rgbFrame(lcd);
+}
+
+
+/**
+ * Draws rounded rectangles
+*/
+static void roundRectanglesFrame(LovyanGFX &canvas, int y0, int frame, void *ctx)
+{
+  int w = canvas.width();
+  int h = *(int*)ctx;
 
-  for(int i = 0 ; i < w/2; i+=7) 
+  for (int i = 0; i <= 7*frame; i += 7)
   {
-    rectR = i+1;
-    rectH = 2 * rectR;
-    lcd.drawRoundRect(0, (h-rectH)/2, w, rectH, rectR, TFT_RED);
-    lcd.drawRoundRect((w-rectH)/2, 0, rectH, h, rectR, TFT_MAGENTA);
-    delay(50);
+    int rectR = i+1;
+    int rectH = 2 * rectR;
+    canvas.drawRoundRect(0, (h-rectH)/2 - y0, w, rectH, rectR, TFT_RED);
+    canvas.drawRoundRect((w-rectH)/2, -y0, rectH, h, rectR, TFT_MAGENTA);
   }
+}
+
+void roundRectangles(LGFX &lcd) 
+{
+  int h = lcd.height();
+  FramePipeline fp(lcd);
+
+  fp.run((lcd.width()/2 + 6) / 7, roundRectanglesFrame, &h);
+  FramePipeline::print("Round_Rectangles");
   rgbFrame(lcd);
 }
 
@@ -258,18 +372,23 @@ void roundRectangles(LGFX &lcd)
 /**
  * Draws filled circles
 */
-void circles(LGFX &lcd)
+static void circlesFrame(LovyanGFX &canvas, int y0, int frame, void *ctx)
 {
-  lcd.fillScreen(TFT_BLACK);
+  Rng rng = activityRng();
+  int w = canvas.width();
+  int h = *(int*)ctx;
 
-  int w = lcd.width();
+  for (int i = 0; i <= 3*frame; i += 3)
+    canvas.fillCircle(w/2, h/2 - y0, w/2 - 2*i, color[rng.below(nbrOfColors)]);
+}
+
+void circles(LGFX &lcd)
+{
   int h = lcd.height();
+  FramePipeline fp(lcd);
 
-  for(int i = 0; i < w/2; i += 3)
-  {
-    lcd.fillCircle(w/2, h/2, w/2 - 2*i, color[random(0,nbrOfColors)]);
-    delay(50); 
-  }
+  fp.run((lcd.width()/2 + 2) / 3, circlesFrame, &h);
+  FramePipeline::print("Circles");
   rgbFrame(lcd);
 }
 
@@ -277,54 +396,54 @@ void circles(LGFX &lcd)
 /**
  * Draws triangles starting in each corner
 */
-void triangles(LGFX &lcd)
+static void trianglesFrame(LovyanGFX &canvas, int y0, int frame, void *ctx)
 {
-  lcd.fillScreen(TFT_BLACK);
+  int w = canvas.width()-1;
+  int h = *(int*)ctx - 1;
 
-  int w = lcd.width()-1;
-  int h = lcd.height()-1;
-  
-  for(int i = 0; i < 2*w/5; i += 5)
+  for (int i = 0; i <= 5*frame; i += 5)
   {
-    lcd.drawTriangle(w/2, 0, 0, h/2, i, i*h/w, TFT_RED);  
-    lcd.drawTriangle(0, h/2, w/2, h, i, (w-i)*h/w, TFT_BLUE); 
-    lcd.drawTriangle(w/2, 0, w, h/2, w-i, i*h/w, TFT_BLUE);  
-    lcd.drawTriangle(w, h/2, w/2, h, w-i, (w-i)*h/w, TFT_RED); 
-    delay(50);
+    canvas.drawTriangle(w/2, -y0, 0, h/2 - y0, i, i*h/w - y0, TFT_RED);  
+    canvas.drawTriangle(0, h/2 - y0, w/2, h - y0, i, (w-i)*h/w - y0, TFT_BLUE); 
+    canvas.drawTriangle(w/2, -y0, w, h/2 - y0, w-i, i*h/w - y0, TFT_BLUE);  
+    canvas.drawTriangle(w, h/2 - y0, w/2, h - y0, w-i, (w-i)*h/w - y0, TFT_RED); 
   }
+}
+
+void triangles(LGFX &lcd)
+{
+  int h = lcd.height();
+  FramePipeline fp(lcd);
+
+  fp.run((2*(lcd.width()-1)/5 + 4) / 5, trianglesFrame, &h);
+  FramePipeline::print("Triangles");
   rgbFrame(lcd);
 }
 
 
 /**
- * Display HSV color circle as a polygon with 120 sides.
- * The color value (H = Hue) changes from 0 ... 360° in steps of 3°.
+ * Display HSV color circle.
+ * The color value (H = Hue) changes from 0 ... 360° and is computed 
+ * per pixel from the angle to the center of the circle.
  * Saturation (S) is set to 1.0 and brightness value (V) to 0.9 and  
  * not the maximum to avoid artifacts.
 */
 void hsvColorCircle(LGFX &lcd)
 {
-  lcd.fillScreen(TFT_BLACK);
-
-  float DEGTORAD = PI/180;
-  int xm = lcd.width()  / 2;
-  int ym = lcd.height() / 2;
-  int xA, yA, xB, yB;
-  int delta = 3;
+  static uint16_t hue[360];
+  static bool hasHue = false;
   int radius = 100;
+  Scanline sl(lcd);
 
-  uint16_t rgb565;
-  
-  for( int h = 0; h < 360; h += delta)
+  if (! hasHue)
   {
-    xA = xm + radius * sin(DEGTORAD * h);
-    yA = ym + radius * cos(DEGTORAD * h);
-    xB = xm + radius * sin(DEGTORAD * (h+delta));
-    yB = ym + radius * cos(DEGTORAD * (h+delta)); 
-
-    HSVtoRGB565(rgb565, h, 1.0, 0.9);
-    lcd.fillTriangle(xm, ym, xA, yA, xB, yB, rgb565); 
+    for (int h = 0; h < 360; h++) HSVtoRGB565(hue[h], h, 1.0, 0.9);
+    hasHue = true;
   }
+
+  sl.begin();
+  sl.conicGradient(0, 0, lcd.width(), lcd.height(), lcd.width()/2, lcd.height()/2, radius, hue, 360, TFT_BLACK);
+  sl.end();
   rgbFrame(lcd);
 }
 
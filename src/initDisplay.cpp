@@ -2,6 +2,8 @@
 #include <LovyanGFX.hpp>
 #include "lgfx_ESP32_2432S028.h"
 #include <SPI.h>
+#include "DisplayList.h"
+#include "GlyphCache.h"
 
 using Action = void(&)(LGFX &lcd);
 
@@ -56,28 +58,31 @@ void framedCrosshair(LGFX &lcd)
   lcd.fillRect(lcd.width()-10,lcd.height()-10, 10, 10, TFT_RED);;
   lcd.setTextSize(1.0);
   sprintf(str, "(0,0) origin, rot=%d", lcd.getRotation());
-  lcd.drawString(str, 25,0);
+  glyphCache.drawText(lcd, str, 25, 0, TFT_WHITE, TFT_BLACK);
 }
 
 /**
  * Draw a grid 20 x 20 
+ * The background and the lines are sent as one compiled display list
 */
 void grid(LGFX &lcd)
 {
   int x = 0, y = 0, d = 20;
-  lcd.fillScreen(TFT_BLACK);
+  StaticDisplayList<48> dl;
+  dl.begin(lcd.width(), lcd.height());
+  dl.fillScreen(TFT_BLACK);
   while (y < lcd.height())
   {
-    lcd.drawLine(0, y, lcd.width(), y, TFT_WHITE);
+    dl.drawLine(0, y, lcd.width(), y, TFT_WHITE);
     y += d;
   }
 
   while (x < lcd.width())
   {
-    lcd.drawLine(x, 0, x, lcd.height(), TFT_WHITE);
+    dl.drawLine(x, 0, x, lcd.height(), TFT_WHITE);
     x += d;
   }
-  
+  dl.flush(lcd);
 }
 
 /**
@@ -127,6 +132,7 @@ void initDisplay(LGFX &lcd, GFXfont *theFont=&defaultFont, Action greet=nop)
     lcd.setTextSize(1.0);
     lcd.setTextDatum(lgfx::textdatum::TL_DATUM);
     lcd.setFont(theFont);
+    glyphCache.setFont(theFont);
     lcd.setRotation(0);
     lcd.setBrightness(64);
     greet(lcd);
@@ -1,5 +1,13 @@
 #include <Arduino.h>
 #include <SD.h>
+#include "SdIO.h"
+#include "SdCatalog.h"
+#include "CaptureStore.h"
+#include "BootStages.h"
+#include <freertos/event_groups.h>
+
+static EventGroupHandle_t sdEvents;
+constexpr EventBits_t SD_READY = 1;
 
 
 /**
@@ -11,15 +19,16 @@
  * SPIClass sdcardSPI(VSPI);
  * in main.cpp 
  * and pass sdcardSPI as argument to initSDcard()
+ * The card runs at the fastest SPI clock at which it works reliably.
 */
 void initSDCard(SPIClass &spi)
 {
   // Use custom SPI class
   spi.begin(TF_SCLK, TF_MISO, TF_MOSI, TF_CS);
-  if (!SD.begin(TF_CS, spi)) // 👉 Use default frequency of 4MHz
+  if (! beginSdCard(spi)) // 👉 tries 40 MHz down to the default frequency of 4MHz
       log_e("==> SD.begin failed!");
   else
-      log_e("==> done");
+      log_e("==> done at %u kHz", sdClock / 1000);
 
 /*     // Use default VSPI with pins 5, 18, 19, 23 (CS, SCLK, MISO, MOSI)
     if (!SD.begin()) // 👉 Use default frequency of 4MHz
@@ -55,6 +64,68 @@ free   %6llu MB
 }
 
 
+/**
+ * Mounts the card and loads the catalog and the capture store while 
+ * the main loop already draws. The reports are printed by waitSDCard() 
+ * in the loop, so they don't interleave with its output.
+*/
+static void sdCardTask(void *param)
+{
+  SPIClass &spi = *(SPIClass*)param;
+  initSDCard(spi);
+  bootStages.mark("sd mounted");
+  if (sdClock)
+  {
+    sdCatalog.begin();
+    bootStages.mark("sd catalog");
+    captureStore.begin();
+  }
+  bootStages.sdReady();
+  log_i("stack left %u bytes", uxTaskGetStackHighWaterMark(NULL));
+  xEventGroupSetBits(sdEvents, SD_READY);
+  vTaskDelete(NULL);
+}
+
+
+/**
+ * Start the SD card in a task on core 0, the loop runs on core 1
+*/
+void startSDCard(SPIClass &spi)
+{
+  sdEvents = xEventGroupCreate();
+  xTaskCreatePinnedToCore(sdCardTask, "sdCardTask", 8192, &spi, 1, NULL, 0);
+}
+
+
+/**
+ * True when the SD card task has finished, doesn't wait. The touch 
+ * controller is on the bus of the card, it can't be read before.
+*/
+bool isSDCardReady()
+{
+  return sdEvents == nullptr || (xEventGroupGetBits(sdEvents) & SD_READY);
+}
+
+
+/**
+ * Wait until the SD card task has finished, returns false without card.
+ * The first call prints the card info and the boot stages.
+*/
+bool waitSDCard()
+{
+  static bool isReported = false;
+  if (sdEvents == nullptr) return sdClock != 0;
+  xEventGroupWaitBits(sdEvents, SD_READY, pdFALSE, pdTRUE, portMAX_DELAY);
+  if (! isReported)
+  {
+    isReported = true;
+    if (sdClock) printSDCardInfo();
+    bootStages.print();
+  }
+  return sdClock != 0;
+}
+
+
 /**
  * Recursively lists all directories/files of 
  * the file system starting at direcory dir
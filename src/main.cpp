@@ -40,9 +40,15 @@
 #include <SD.h>
 #include "PulseGen.h"
 #include "Turtle.h"
+#include "Activity.h"
+#include "MemTelemetry.h"
+#include "Arena.h"
+#include "SdCatalog.h"
+#include "CaptureStore.h"
+#include "BootStages.h"
+#include "Hud.h"
+#include "ThumbAtlas.h"
 
-using Action   = void(&)(LGFX &lcd);
-using Activity = struct act{const char *name; Action f;};
 GFXfont myFont = fonts::DejaVu18;
 
 
@@ -51,51 +57,24 @@ extern void calibrateTouchPad(LGFX &lcd);
 extern void nop(LGFX &lcd);
 extern void framedCrosshair(LGFX &lcd);
 extern void grid(LGFX &lcd);
+extern void handleSerialCommands();
 extern void initDisplay(LGFX &lcd, GFXfont *theFont, Action greet=nop);
 extern void initSDCard(SPIClass &spi);
+extern void startSDCard(SPIClass &spi);
+extern bool waitSDCard();
+extern bool isSDCardReady();
 extern void lcdInfo(LGFX &lcd);
 extern void listFiles(File dir, int indent=0);
 extern void printSDCardInfo();
 extern void printSystemInfo();
 extern void rgb2hsv(uint8_t r, uint8_t g, uint8_t b, uint32_t &h, uint32_t &s, uint32_t &v);
+extern int  runMenu(LGFX &lcd);
+extern bool menuRequest;
 
 extern bool saveBmpToSD_16bit(LGFX &lcd, const char *filename);
 extern bool saveBmpToSD_24bit(LGFX &lcd, const char *filename);
 
 
-// Graphical examples defined in graphicPatterns.cpp
-extern void barnsleyFern(LGFX &lcd);
-extern void circles(LGFX &lcd);
-extern void colorTiles(LGFX &lcd);
-extern void colorGradients(LGFX &lcd);
-extern void hsvColorCircle(LGFX &lcd);
-extern void mandelbrot(LGFX &lcd);
-extern void rainbowStripes(LGFX &lcd);
-extern void randomDots(LGFX &lcd);
-extern void rectangles(LGFX &lcd);
-extern void rgbTiles(LGFX &lcd);
-extern void rgbFrame(LGFX &lcd);
-extern void roundRectangles(LGFX &lcd);
-extern void sierpinskiTriangle(LGFX &lcd);
-extern void triangles(LGFX &lcd);
-
-// Recursive turtle graphics
-extern void sevenSpirals(LGFX &lcd);
-extern void fiveKochSnowflakes(LGFX &lcd);
-extern void cCurves1(LGFX &lcd);
-extern void cCurves2(LGFX &lcd);
-extern void cCurves3(LGFX &lcd);
-extern void dragonCurves1(LGFX &lcd);
-extern void dragonCurves2(LGFX &lcd);
-extern void dragonCurves3(LGFX &lcd);
-extern void sierpinskiTriangles01(LGFX &lcd);
-extern void sierpinskiTriangles23(LGFX &lcd);
-extern void sierpinskiTriangles45(LGFX &lcd);
-extern void shamrocks02(LGFX &lcd);
-extern void shamrocks3(LGFX &lcd);
-extern void shamrocks4(LGFX &lcd);
-
-
 // All defined TFT-Colors
 int color[] = {  TFT_BLACK,       TFT_RED,       TFT_MAROON,    TFT_BROWN,
                  TFT_ORANGE,      TFT_GOLD,      TFT_YELLOW,    TFT_OLIVE,
@@ -149,45 +128,6 @@ int rainbowColor[] =
 };
 int nbrOfRainbowColors = sizeof(rainbowColor) / sizeof(rainbowColor[0]);
 
-Activity activity[] = {  
-                        {"RGB_Tiles",        rgbTiles},
-                        {"Rainbow_Stripes",  rainbowStripes},
-                        {"Color_Tiles",      colorTiles},
-                        {"Color_Gradients",  colorGradients},
-                        {"Circles",          circles},
-                        {"Rectangles",       rectangles},
-                        {"Round_Rectangles", roundRectangles},
-                        {"Triangles",        triangles},
-                        {"HSV_ColorCircle",  hsvColorCircle},
-                        {"Random_Dots",      randomDots},
-                        {"Barnsley_Fern",    barnsleyFern}, 
-                        {"Mandelbrot",       mandelbrot},
-                        {"Sierpinski",       sierpinskiTriangle},
-                        {"Spirals",          sevenSpirals},
-                        {"Snowflakes",       fiveKochSnowflakes},
-                        {"C_Curves1",        cCurves1},
-                        {"C_Curves2",        cCurves2},
-                        {"C_Curves3",        cCurves3},
-                        {"Dragon_Curves1",   dragonCurves1},
-                        {"Dragon_Curves2",   dragonCurves2},
-                        {"Dragon_Curves3",   dragonCurves3},
-                        {"Sierpinski_01",    sierpinskiTriangles01},
-                        {"Sierpinski_23",    sierpinskiTriangles23},
-                        {"Sierpinski_45",    sierpinskiTriangles45},
-                        {"Shamrocks_02",     shamrocks02},
-                        {"Shamrocks_3",     shamrocks3},
-                        {"Shamrocks_4",     shamrocks4},
-                      };
-constexpr int nbrActivities = sizeof(activity) / sizeof(activity[0]);
-
-// Portrait = 0, Landscape = 1, Portrait reversed = 2, Landscape reversed = 3
-// and the corresponding mirrored orientations 4..7
-// The width of the display must be the larger dimension of the display 
-// and the rotation offset must be 5 for lcd and 0 for touch pad
-enum class ROT { PORTRAIT,    LANDSCAPE,   R_PORTRAIT,  R_LANDSCAPE, 
-                 M_PORTRAIT,  M_LANDSCAPE, RM_PORTRAIT, RM_LANDSCAPE 
-               };
-
 LGFX lcd;
 
 SPIClass sdcardSPI(VSPI); // Saved bitmaps on SD card are empty (all white), but touchscreen works
@@ -246,16 +186,24 @@ void takeScreenshot(const char *filename)
 void setup() 
 {
   Serial.begin(115200);
-  Serial.printf("stack: %d\n", uxTaskGetStackHighWaterMark(NULL));
+  beginArenas();      // before anything else can fragment the heap
+  bootStages.mark("arenas");
+  thumbAtlas.setTable(activityTableHash());   // thumbnails of other activities are dropped
+  //initDisplay(lcd,  &myFont, calibrateTouchPad);  // Initialize the LCD and ask for calibration
+  initDisplay(lcd, &myFont, nop);  // Initialize the LCD, the screen is black
+  bootStages.mark("display");
+  // Mounts the SD card 👉after👈 the display in a task on core 0, loads the 
+  // catalog (/catalog.idx) and starts the capture store in the background
+  startSDCard(sdcardSPI);
   // Starts the blinking task, which causes the RGB LED to flash 
   // red, green and blue alternately every second
-  xTaskCreate(blinkTask, "blinkTask", 1024, NULL, 10, NULL);
+  TaskHandle_t blinkHandle = nullptr;
+  xTaskCreate(blinkTask, "blinkTask", 1024, NULL, 10, &blinkHandle);
+  memTelemetry.watch(xTaskGetCurrentTaskHandle(), "loopTask");
+  memTelemetry.watch(blinkHandle, "blinkTask");
+  bootStages.mark("tasks");
+  lcdInfo(lcd);
   printSystemInfo();
-  //initDisplay(lcd,  &myFont, calibrateTouchPad);  // Initialize the LCD and ask for calibration
-  initDisplay(lcd, &myFont, lcdInfo);  // Initialize the LCD and show info
-  initSDCard(sdcardSPI);      // Initialize SD card 👉after👈 display
-  printSDCardInfo();
-  listFiles(SD.open("/"));
 /* 
   // Read a jpg color swatch and save it as rgb565-bitmap
   // 👉 The colors ar not correct! 
@@ -274,26 +222,45 @@ void setup()
   uint32_t h,s,v;
   rgb2hsv(r,g,b, h,s,v);
   Serial.printf("R=%d, G=%d, B=%d --> h=%d, S=%d, V=%d\n", r,g,b, h,s,v);
+  memTelemetry.print();
+  bootStages.mark("setup");
   log_e("==> done");
 }
 
 
 void loop() 
 {
-  int x, y;
-  if (lcd.getTouch(&x, &y))               // ❗ Touchscreen doesn't work
-    Serial.printf("x=%d y=%d\n", x, y);
-
   // Show all defined graphical patterns
   for( int i = 0; i < nbrActivities; i++)
   {
+    // A touch (❗ doesn't work together with the SD card) or the 
+    // command menu opens the menu, the cycle continues after the 
+    // activity selected there. The touch shares the bus with the 
+    // card, it is read only after the SD card task has finished.
+    int x, y;
+    if (menuRequest || (isSDCardReady() && lcd.getTouch(&x, &y)))
+    {
+      int selected = runMenu(lcd);
+      if (selected >= 0) i = selected;
+    }
     Serial.printf("%s\n", activity[i].name);
-    activity[i].f(lcd);
-    char buf[64];
-    snprintf(buf, 64, "/%02d_%s_16.bmp", i, activity[i].name);
-    saveBmpToSD_16bit(lcd, buf);
-    snprintf(buf, 64, "/%02d_%s_24.bmp", i, activity[i].name);
-    saveBmpToSD_24bit(lcd, buf);
+    runActivity(lcd, i);
+    bootStages.firstPixel();        // the first activity is on the panel
+    waitSDCard();                   // the screenshots need the card
+    // the HUD replaces the pixels below it, no screenshots while it is on
+    if (! Hud::enabled)
+    {
+      char buf[CaptureStore::NAME_LEN];
+      snprintf(buf, sizeof(buf), "%02d_%s_16.bmp", i, activity[i].name);
+      thumbAtlas.request(i);        // the menu preview, from the 16 bit screenshot
+      captureStore.save(lcd, buf, saveBmpToSD_16bit);
+      snprintf(buf, sizeof(buf), "%02d_%s_24.bmp", i, activity[i].name);
+      captureStore.save(lcd, buf, saveBmpToSD_24bit);
+    }
+    hud.invalidate();               // the activity may have drawn over it
+    hud.draw(lcd);
+    sdCatalog.save();
+    handleSerialCommands();
     delay (3000);
   }
 }
@@ -0,0 +1,257 @@
+#include <Arduino.h>
+#include "Activity.h"
+#include "GlyphCache.h"
+#include "VScroll.h"
+#include "ThumbAtlas.h"
+
+extern bool waitSDCard();
+
+constexpr int TITLE_H  = 24;      // fixed title bar above the scroll area
+constexpr int TILE_H   = 84;      // one tile per activity
+constexpr int THUMB_X  = 4;
+constexpr int THUMB_W  = ThumbAtlas::W;
+constexpr int THUMB_H  = ThumbAtlas::H;
+constexpr int TEXT_X   = THUMB_X + THUMB_W + 8;
+constexpr int STRIDE   = (VScroll::MAX_WIDTH + 31) / 32;
+
+constexpr uint32_t TICK_MS    = 16;       // ~60 frames per second
+constexpr uint32_t TIMEOUT_MS = 15000;    // back to the cycle without a touch
+constexpr uint32_t TAP_MS     = 400;      // longer touches don't select
+constexpr int      TAP_SLOP   = 8;        // rows a tap may move
+constexpr float    FRICTION   = 0.95f;    // velocity kept per tick
+constexpr float    MIN_SPEED  = 0.02f;    // rows per ms, the fling stops below
+
+constexpr uint16_t TITLE_BG   = TFT_NAVY;
+constexpr uint16_t TILE_BG    = TFT_BLACK;
+constexpr uint16_t PRESSED_BG = 0x2124;   // dark grey
+constexpr uint16_t SEPARATOR  = TFT_DARKGREY;
+constexpr uint16_t TEXT_FG    = TFT_WHITE;
+const uint16_t costColor[] = {TFT_DARKGREEN, TFT_NAVY, TFT_MAROON};
+
+bool menuRequest = false;         // set by the serial command menu
+static GlyphCache menuFont;
+static int pressedTile = -1;
+
+static inline uint16_t swap565(uint16_t c) { return (c << 8) | (c >> 8); }
+
+
+/**
+ * Set the pixels of row r of the text s, whose box starts
+ * at row y of the tile, in the mask of one row
+*/
+static void textRow(const char *s, int x, int y, int r, uint32_t *mask)
+{
+  if (r < y || r >= y + menuFont.height()) return;
+  for (; *s; s++)
+  {
+    menuFont.drawMask(*s, mask, STRIDE, 1, x, y - r);
+    x += menuFont.advance(*s);
+  }
+}
+
+
+/**
+ * Render content row c of the menu: the tiles of the activities,
+ * each with its thumbnail, or its number in its cost color while
+ * there is none, its name, cost class and render path and its best 
+ * render time
+*/
+static void menuRow(int c, uint16_t *line, int width, void *ctx)
+{
+  const int i = c / TILE_H, r = c % TILE_H;
+  if (i >= nbrActivities || r >= THUMB_H)
+  {
+    uint16_t bg = swap565(i < nbrActivities && r == THUMB_H + 2 ? SEPARATOR : TILE_BG);
+    for (int x = 0; x < width; x++) line[x] = bg;
+    return;
+  }
+
+  const char *costName[] = {"light", "medium", "heavy"};
+  const char *bufName[]  = {"direct", "line", "tile", "frame"};
+  const Activity &a = activity[i];
+  const int lineH = menuFont.height();
+  char s[32];
+  uint32_t mask[STRIDE] = {0};
+  const uint16_t *thumbRow = thumbAtlas.row(i, r);
+  if (thumbRow == nullptr)
+  {
+    snprintf(s, sizeof(s), "%02d", i);
+    textRow(s, THUMB_X + (THUMB_W - menuFont.textWidth(s)) / 2, (THUMB_H - lineH) / 2, r, mask);
+  }
+  textRow(a.name, TEXT_X, 8, r, mask);
+  if (r >= 8 + lineH + 4 && r < 8 + 3 * lineH + 8)
+  {
+    snprintf(s, sizeof(s), "%s, %s", costName[(int)a.cost], bufName[(int)a.buffer]);
+    textRow(s, TEXT_X, 8 + lineH + 4, r, mask);
+    const ActivityStats &st = activityStats[i];
+    if (st.runs) snprintf(s, sizeof(s), "%.1f ms", st.minUs / 1000.0);
+    else         snprintf(s, sizeof(s), "not run yet");
+    textRow(s, TEXT_X, 8 + 2 * lineH + 8, r, mask);
+  }
+
+  const uint16_t fg = swap565(TEXT_FG);
+  const uint16_t bg = swap565(i == pressedTile ? PRESSED_BG : TILE_BG);
+  const uint16_t thumb = swap565(costColor[(int)a.cost]);
+  for (int x = 0; x < width; x++)
+  {
+    if (mask[x >> 5] & (1u << (x & 31))) line[x] = fg;
+    else if (x < THUMB_X || x >= THUMB_X + THUMB_W) line[x] = bg;
+    else line[x] = thumbRow ? thumbRow[x - THUMB_X] : thumb;
+  }
+}
+
+
+/**
+ * The tile under the screen row y, -1 for none
+*/
+static int tileAt(const VScroll &vs, int y)
+{
+  if (y < TITLE_H) return -1;
+  int c = vs.offset() + y - TITLE_H;
+  int i = c / TILE_H;
+  return i < nbrActivities && c % TILE_H < THUMB_H ? i : -1;
+}
+
+
+/**
+ * Highlight tile i (-1 for none), only the rows of the
+ * old and the new highlighted tile are rendered again
+*/
+static void press(VScroll &vs, int i)
+{
+  if (i == pressedTile) return;
+  int old = pressedTile;
+  pressedTile = i;
+  if (old >= 0) vs.refresh(old * TILE_H, old * TILE_H + THUMB_H);
+  if (i >= 0)   vs.refresh(i * TILE_H, i * TILE_H + THUMB_H);
+}
+
+
+/**
+ * Move the highlight from the serial monitor: u and d move it one
+ * tile up or down, s selects the highlighted tile, q closes the menu.
+ * Returns the tile selected, -2 for q, else -1. The offset is moved 
+ * so that the highlighted tile is visible.
+*/
+static int serialKeys(VScroll &vs, float &pos)
+{
+  int selected = -1;
+  while (Serial.available())
+  {
+    int i = pressedTile;
+    switch (Serial.read())
+    {
+      case 'u': i = i < 0 ? 0 : std::max(i - 1, 0); break;
+      case 'd': i = i < 0 ? 0 : std::min(i + 1, nbrActivities - 1); break;
+      case 's': if (i >= 0) selected = i; continue;
+      case 'q': selected = -2; continue;
+      default:  continue;
+    }
+    press(vs, i);
+    if (i * TILE_H < pos) pos = i * TILE_H;
+    if (i * TILE_H + TILE_H > pos + vs.height()) pos = i * TILE_H + TILE_H - vs.height();
+  }
+  return selected;
+}
+
+
+/**
+ * Show the activities as a list of tiles below a title bar and
+ * return the one tapped, or -1 when nothing was touched for
+ * TIMEOUT_MS.
+ *
+ * The list is moved by the hardware scrolling of the panel, a frame
+ * costs only the rows that come into view. Dragging moves the list
+ * with the finger, on release it keeps the speed of the finger and
+ * slows down by FRICTION every tick until it stops or hits an end.
+ * Without touch the menu is used from the serial monitor, see 
+ * serialKeys().
+*/
+int runMenu(LGFX &lcd)
+{
+  menuRequest = false;
+  lcd.setRotation(static_cast<uint8_t>(ROT::PORTRAIT));
+  menuFont.setFont(&fonts::DejaVu12);
+  lcd.fillRect(0, 0, lcd.width(), TITLE_H, TITLE_BG);
+  glyphCache.drawText(lcd, "Activities", 6, (TITLE_H - glyphCache.height()) / 2, TEXT_FG, TITLE_BG);
+
+  waitSDCard();                   // for the thumbnails
+  thumbAtlas.open();
+  VScroll vs(lcd);
+  pressedTile = -1;
+  if (! vs.begin(TITLE_H, 0, menuRow, nullptr))
+  {
+    thumbAtlas.close();
+    return -1;
+  }
+  const int maxOffset = std::max(0, nbrActivities * TILE_H - vs.height());
+
+  Serial.printf("menu: u/d move, s selects, q closes\n");
+  float pos = 0, v = 0;           // offset and speed in rows per ms
+  bool down = false, moved = false;
+  int startY = 0, lastY = 0, selected = -1;
+  uint32_t downMs = 0, lastMs = 0, idleMs = millis();
+  while (selected == -1 && millis() - idleMs < TIMEOUT_MS)
+  {
+    uint32_t tick = millis();
+    int x, y;
+    if (Serial.available())
+    {
+      idleMs = tick;
+      v = 0;
+      selected = serialKeys(vs, pos);
+    }
+    else if (lcd.getTouch(&x, &y))
+    {
+      idleMs = tick;
+      if (! down)
+      {
+        down = true;
+        moved = false;
+        startY = lastY = y;
+        downMs = lastMs = tick;
+        v = 0;
+        press(vs, tileAt(vs, y));
+      }
+      else
+      {
+        int dy = lastY - y;
+        uint32_t dt = tick - lastMs;
+        pos += dy;
+        if (dt) v = 0.7f * v + 0.3f * dy / dt;
+        if (abs(y - startY) > TAP_SLOP && ! moved)
+        {
+          moved = true;
+          press(vs, -1);
+        }
+        lastY = y;
+        lastMs = tick;
+      }
+    }
+    else if (down)
+    {
+      down = false;
+      if (! moved && pressedTile >= 0 && tick - downMs < TAP_MS) selected = pressedTile;
+      else press(vs, -1);
+      if (tick - lastMs > 3 * TICK_MS) v = 0;   // the finger rested before it was lifted
+    }
+    else if (v != 0)
+    {
+      pos += v * TICK_MS;
+      v *= FRICTION;
+      if (fabsf(v) < MIN_SPEED) v = 0;
+    }
+    if (pos < 0)         { pos = 0;         v = 0; }
+    if (pos > maxOffset) { pos = maxOffset; v = 0; }
+    vs.scrollTo((int)pos);
+
+    int32_t wait = TICK_MS - (millis() - tick);
+    if (wait > 0) delay(wait);
+  }
+  vs.end();
+  thumbAtlas.close();
+  pressedTile = -1;
+  lcd.fillScreen(TFT_BLACK);
+  if (selected >= 0) Serial.printf("menu: %s selected\n", activity[selected].name);
+  return selected >= 0 ? selected : -1;
+}
@@ -2,19 +2,31 @@
 #include <SD.h>
 #include <LovyanGFX.hpp>
 #include "lgfx_ESP32_2432S028.h"
+#include "Arena.h"
+#include "SdIO.h"
+#include "ThumbAtlas.h"
 
 
 bool saveBmpToSD_16bit(LGFX &lcd, const char *filename)
 {
   bool result = false;
-  File file = SD.open(filename, "w");
-  if (file)
+  int width  = lcd.width();
+  int height = lcd.height();
+  int rowSize = (2 * width + 3) & ~ 3;
+  // the row buffer and the thumbnail are taken before the buffer of the writer,
+  // which close() returns first
+  ArenaScope scope(frameArena);
+  std::uint8_t *buffer = frameArena.alloc<std::uint8_t>(rowSize);
+  if (buffer == nullptr)
+  {
+    log_e("No memory for a row of %d bytes", rowSize);
+    return false;
+  }
+  // a requested thumbnail is scaled down from the same rows
+  bool thumbnail = thumbAtlas.begin(width, height);
+  SdWriter file;    // the size is known, the file is allocated at once
+  if (file.open(filename, rowSize * height + sizeof(lgfx::bitmap_header_t)))
   {
-    int width  = lcd.width();
-    int height = lcd.height();
-
-    int rowSize = (2 * width + 3) & ~ 3;
-
     lgfx::bitmap_header_t bmpheader;
     bmpheader.bfType = 0x4D42;
     bmpheader.bfSize = rowSize * height + sizeof(bmpheader);
@@ -28,15 +40,15 @@ bool saveBmpToSD_16bit(LGFX &lcd, const char *filename)
     bmpheader.biCompression = 3;
 
     file.write((std::uint8_t*)&bmpheader, sizeof(bmpheader));
-    std::uint8_t buffer[rowSize];
     memset(&buffer[rowSize - 4], 0, 4);
     for (int y = lcd.height() - 1; y >= 0; y--)
     {
       lcd.readRect(0, y, lcd.width(), 1, (lgfx::rgb565_t*)buffer);
+      if (thumbnail) thumbAtlas.addRow((uint16_t*)buffer, y);
       file.write(buffer, rowSize);
     }
-    file.close();
-    result = true;
+    if (thumbnail) thumbAtlas.finish();
+    result = file.close();
   }
   else
   {
@@ -50,14 +62,20 @@ bool saveBmpToSD_16bit(LGFX &lcd, const char *filename)
 bool saveBmpToSD_24bit(LGFX &lcd, const char *filename)
 {
   bool result = false;
-  File file = SD.open(filename, "w");
-  if (file)
+  int width  = lcd.width();
+  int height = lcd.height();
+  int rowSize = (3 * width + 3) & ~ 3;
+  // the row buffer is taken before the buffer of the writer, which close() returns first
+  ArenaScope scope(frameArena);
+  std::uint8_t *buffer = frameArena.alloc<std::uint8_t>(rowSize);
+  if (buffer == nullptr)
+  {
+    log_e("No memory for a row of %d bytes", rowSize);
+    return false;
+  }
+  SdWriter file;    // the size is known, the file is allocated at once
+  if (file.open(filename, rowSize * height + sizeof(lgfx::bitmap_header_t)))
   {
-    int width  = lcd.width();
-    int height = lcd.height();
-
-    int rowSize = (3 * width + 3) & ~ 3;
-
     lgfx::bitmap_header_t bmpheader;
     bmpheader.bfType = 0x4D42;
     bmpheader.bfSize = rowSize * height + sizeof(bmpheader);
@@ -71,15 +89,13 @@ bool saveBmpToSD_24bit(LGFX &lcd, const char *filename)
     bmpheader.biCompression = 0;
 
     file.write((std::uint8_t*)&bmpheader, sizeof(bmpheader));
-    std::uint8_t buffer[rowSize];
     memset(&buffer[rowSize - 4], 0, 4);
     for (int y = lcd.height() - 1; y >= 0; y--)
     {
       lcd.readRect(0, y, lcd.width(), 1, (lgfx::rgb888_t*)buffer);
       file.write(buffer, rowSize);
     }
-    file.close();
-    result = true;
+    result = file.close();
   }
   else
   {
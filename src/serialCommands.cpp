@@ -0,0 +1,353 @@
+#include <Arduino.h>
+#include <SD.h>
+#include "Activity.h"
+#include "DrawTrace.h"
+#include "Rng.h"
+#include "FramePipeline.h"
+#include "AALines.h"
+#include "MemTelemetry.h"
+#include "Arena.h"
+#include "SdCatalog.h"
+#include "SdIO.h"
+#include "CaptureStore.h"
+#include "BootStages.h"
+#include "Hud.h"
+#include "ScrollLog.h"
+
+extern LGFX lcd;
+extern void benchmarkDots(LGFX &lcd, uint32_t seed);
+extern void benchmarkCurves(LGFX &lcd);
+extern bool menuRequest;
+
+using Handler = void(&)(const char *args);
+using Command = struct cmd{const char *name; Handler f; const char *help;};
+
+void printHelp(const char *args);
+void printStats(const char *args) { printActivityTable(); }
+void setProfileOutput(const char *args);
+void recordTrace(const char *args);
+void replayTrace(const char *args);
+void dotsBenchmark(const char *args);
+void setSeed(const char *args);
+void rngBenchmark(const char *args);
+void setFps(const char *args);
+void toggleAntiAliasing(const char *args);
+void printMemory(const char *args);
+void listDirectory(const char *args) { sdCatalog.list(*args ? args : "/"); }
+void rescanCard(const char *args);
+void sdCardBenchmark(const char *args);
+void setRetention(const char *args);
+void printBootStages(const char *args) { bootStages.print(); }
+void toggleHud(const char *args);
+void openMenu(const char *args) { menuRequest = true; }
+void showLog(const char *args) { runLog.show(lcd); }
+
+Command command[] = {
+                      {"help",    printHelp,        "show this list"},
+                      {"stats",   printStats,       "print the activity table with render times"},
+                      {"profile", setProfileOutput, "off|serial|sd  output of the draw call profile"},
+                      {"trace",   recordTrace,      "<n>  record the draw calls of activity n on its next run"},
+                      {"replay",  replayTrace,      "<n> [lcd|sprite]  replay the trace of activity n"},
+                      {"dots",    dotsBenchmark,    "[seed]  draw the random dots with fillCircle and with strips"},
+                      {"seed",    setSeed,          "<n>|random  run the activities with a fixed seed or a new one each run"},
+                      {"rng",     rngBenchmark,     "compare random() with the xoshiro generator"},
+                      {"fps",     setFps,           "<n>  target frame rate of the animations"},
+                      {"aa",      toggleAntiAliasing, "[bench]  switch the anti-aliased curves on or off, or time both"},
+                      {"menu",    openMenu,         "open the touch menu of the activities before the next one"},
+                      {"log",     showLog,          "scroll through the render times of the last runs on the screen"},
+                      {"hud",     toggleHud,        "show fps, frame time, bytes/s, heap and SPI use on the screen"},
+                      {"boot",    printBootStages,  "print the times of the boot stages"},
+                      {"mem",     printMemory,      "print free heap, largest blocks, stack high-water marks and arenas"},
+                      {"ls",      listDirectory,    "[dir]  list a directory of the SD card from the catalog"},
+                      {"rescan",  rescanCard,       "scan the SD card again and rewrite the catalog"},
+                      {"sdbench", sdCardBenchmark,  "[KB]  write and read a test file, print MB/s and latencies"},
+                      {"captures", setRetention,    "[files [MB]]  show the screenshots kept or set how many are kept"},
+                    };
+constexpr int nbrCommands = sizeof(command) / sizeof(command[0]);
+
+
+void printHelp(const char *args)
+{
+  Serial.printf("\nCommands\n--------\n");
+  for (int i = 0; i < nbrCommands; i++)
+    Serial.printf("%-10s %s\n", command[i].name, command[i].help);
+  Serial.printf("\n");
+}
+
+
+/**
+ * Select where the draw call profile of each activity goes: 
+ * to the serial monitor or appended to /profile.csv on the SD card
+*/
+void setProfileOutput(const char *args)
+{
+#ifdef LGFX_PROFILE
+  if      (strcmp(args, "off") == 0)    drawProfiler.output(PROFILE_OUT::OFF);
+  else if (strcmp(args, "serial") == 0) drawProfiler.output(PROFILE_OUT::CONSOLE);
+  else if (strcmp(args, "sd") == 0)     drawProfiler.output(PROFILE_OUT::CARD);
+  else Serial.printf("usage: profile off|serial|sd\n");
+#else
+  Serial.printf("built without LGFX_PROFILE, add -D LGFX_PROFILE to the build_flags\n");
+#endif
+}
+
+
+/**
+ * Parse the number of an activity, returns -1 if it is invalid
+*/
+int activityNumber(const char *args)
+{
+  char *end;
+  long i = strtol(args, &end, 10);
+  if (end == args || i < 0 || i >= nbrActivities) 
+  {
+    Serial.printf("activity number 0..%d expected\n", nbrActivities - 1);
+    return -1;
+  }
+  return i;
+}
+
+
+void recordTrace(const char *args)
+{
+#ifdef LGFX_TRACE
+  int i = activityNumber(args);
+  if (i < 0) return;
+  requestTrace(i);
+  Serial.printf("%s will be recorded on its next run\n", activity[i].name);
+#else
+  Serial.printf("built without LGFX_TRACE, add -D LGFX_TRACE to the build_flags\n");
+#endif
+}
+
+
+/**
+ * Replay a recorded trace on the lcd or into an off-screen sprite 
+ * and report the time it takes to execute the draw calls
+*/
+void replayTrace(const char *args)
+{
+  int i = activityNumber(args);
+  if (i < 0) return;
+
+  char path[48];
+  traceFilename(path, sizeof(path), i);
+  File file;
+  if (sdCatalog.find(path) == nullptr || ! (file = SD.open(path)))
+  {
+    Serial.printf("no trace %s\n", path);
+    return;
+  }
+
+  TraceInfo info = {};
+  bool isOk;
+  uint32_t start = micros();
+  if (strstr(args, "sprite"))
+  {
+    LGFX_Sprite sprite(&lcd);
+    sprite.setColorDepth(8);    // a 16 bit full screen sprite doesn't fit into memory
+    if (! sprite.createSprite(lcd.width(), lcd.height()))
+    {
+      Serial.printf("not enough memory for the sprite\n");
+      file.close();
+      return;
+    }
+    start = micros();
+    isOk = DrawTrace::replay(file, sprite, &info);
+    sprite.deleteSprite();
+  }
+  else
+    isOk = DrawTrace::replay(file, lcd, &info);
+  uint32_t us = micros() - start;
+  file.close();
+
+  if (! isOk)
+  {
+    Serial.printf("%s is damaged after %u commands\n", path, info.commands);
+    return;
+  }
+  Serial.printf("%s replayed: %u commands in %.1f ms, seed %u\n", path, info.commands, us / 1000.0, info.seed);
+}
+
+
+/**
+ * Benchmark of the random dots, with a fixed seed both runs draw 
+ * the same image
+*/
+void dotsBenchmark(const char *args)
+{
+  char *end;
+  unsigned long seed = strtoul(args, &end, 10);
+  if (end == args || seed == 0) seed = 12345;
+  benchmarkDots(lcd, seed);
+}
+
+void setSeed(const char *args)
+{
+  char *end;
+  unsigned long seed = strtoul(args, &end, 10);
+  if (strcmp(args, "random") == 0) 
+  {
+    fixSeed(0);
+    Serial.printf("new seed for every run\n");
+  }
+  else if (end != args && seed != 0)
+  {
+    fixSeed(seed);
+    Serial.printf("all activities run with seed %lu\n", seed);
+  }
+  else Serial.printf("usage: seed <n>|random, n > 0\n");
+}
+
+
+/**
+ * Time per number of random(), Rng::below() and Rng::fillBelow()
+*/
+void rngBenchmark(const char *args)
+{
+  constexpr int N = 10000;
+  ArenaScope scope(frameArena);
+  uint16_t *buf = frameArena.alloc<uint16_t>(N);
+  if (buf == nullptr)
+  {
+    Serial.printf("no memory for %d numbers\n", N);
+    return;
+  }
+  volatile uint32_t sink = 0;
+  Rng rng(12345);
+
+  uint32_t start = micros();
+  for (int i = 0; i < N; i++) sink += random(0, 240);
+  uint32_t arduino = micros() - start;
+
+  start = micros();
+  for (int i = 0; i < N; i++) sink += rng.below(240);
+  uint32_t below = micros() - start;
+
+  start = micros();
+  rng.fillBelow(buf, N, 240);
+  uint32_t bulk = micros() - start;
+
+  Serial.printf("random()     %6.1f ns\n", arduino * 1000.0 / N);
+  Serial.printf("below()      %6.1f ns\n", below * 1000.0 / N);
+  Serial.printf("fillBelow()  %6.1f ns\n", bulk * 1000.0 / N);
+}
+
+void setFps(const char *args)
+{
+  int fps = atoi(args);
+  if (fps < 1 || fps > 100)
+  {
+    Serial.printf("usage: fps <1..100>\n");
+    return;
+  }
+  FramePipeline::targetFps = fps;
+  Serial.printf("animations run at %d fps\n", fps);
+}
+
+void toggleAntiAliasing(const char *args)
+{
+  if (strcmp(args, "bench") == 0)
+  {
+    benchmarkCurves(lcd);
+    return;
+  }
+  AALines::enabled = ! AALines::enabled;
+  Serial.printf("anti-aliased curves %s\n", AALines::enabled ? "on" : "off");
+}
+
+
+void printMemory(const char *args)
+{
+  memTelemetry.print();
+  printArenas();
+}
+
+
+/**
+ * Needed when files were changed on another computer without 
+ * changing the used space of the card
+*/
+void rescanCard(const char *args)
+{
+  sdCatalog.rebuild();
+  sdCatalog.save();
+  Serial.printf("%d entries\n", sdCatalog.count());
+}
+
+
+void sdCardBenchmark(const char *args)
+{
+  long kBytes = *args ? strtol(args, nullptr, 10) : 1024;
+  if (kBytes <= 0) 
+  {
+    Serial.printf("usage: sdbench [KB]\n");
+    return;
+  }
+  sdBenchmark(kBytes);
+}
+
+
+/**
+ * Show the capture store, or set the number of screenshots 
+ * and the megabytes kept before the oldest ones are deleted
+*/
+void setRetention(const char *args)
+{
+  char *end;
+  long files = strtol(args, &end, 10);
+  if (end != args)
+  {
+    long mb = strtol(end, &end, 10);
+    if (files < 1 || files > CaptureStore::MAX_FILES || mb < 0)
+    {
+      Serial.printf("usage: captures [files [MB]], files 1..%d\n", CaptureStore::MAX_FILES);
+      return;
+    }
+    captureStore.maxFiles = files;
+    if (mb > 0) captureStore.maxBytes = (uint32_t)mb << 20;
+  }
+  captureStore.print();
+}
+
+
+void toggleHud(const char *args)
+{
+  Hud::enabled = ! Hud::enabled;
+  Serial.printf("HUD %s\n", Hud::enabled ? "on, no screenshots while it is shown" : "off");
+}
+
+
+/**
+ * Collect characters from the serial monitor without blocking 
+ * and execute the command when a line is complete.
+ * The first word selects the command, the rest is passed as argument.
+*/
+void handleSerialCommands()
+{
+  static char line[64];
+  static int len = 0;
+
+  while (Serial.available())
+  {
+    char c = Serial.read();
+    if (c == '\r') continue;
+    if (c != '\n')
+    {
+      if (len < (int)sizeof(line) - 1) line[len++] = c;
+      continue;
+    }
+    line[len] = '\0';
+    len = 0;
+
+    char *args = strchr(line, ' ');
+    if (args) *args++ = '\0';
+    else      args = line + strlen(line);
+    if (line[0] == '\0') continue;
+
+    int i = 0;
+    while (i < nbrCommands && strcmp(line, command[i].name) != 0) i++;
+    if (i < nbrCommands) command[i].f(args);
+    else Serial.printf("unknown command '%s', try 'help'\n", line);
+  }
+}